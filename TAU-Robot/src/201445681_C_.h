@@ -1,26 +1,10 @@
 #ifndef ___201445681_C__H_
 #define ___201445681_C__H_
 
-#include <vector>
-#include <map>
-using namespace std;
+#include "OrderedAlgorithm.h"
 
 
-#include "Direction.h"
-#include "Configuration.h"
-#include "RobotInformation.h"
-#include "AlgorithmBase.h"
-
-class _201445681_C : public AlgorithmBase
-{
-	vector<Direction> _myOrder;
-
-public:
-	_201445681_C();
-	_201445681_C(const AbstractSensor& sensor, const Configuration& conf) : AlgorithmBase(sensor, conf) {}
-
-	Direction step(Direction prevStep);
-};
+typedef OrderedAlgorithm<Direction::West, Direction::East, Direction::North, Direction::South> _201445681_C;
 
 
 #endif //___201445681_C__H_
\ No newline at end of file
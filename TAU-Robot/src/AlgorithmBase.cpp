@@ -11,12 +11,62 @@ AlgorithmBase::AlgorithmBase()
 	{
 		_house[i] = new char[MAXHOUSELENGTH + 1];
 		_house[i][MAXHOUSELENGTH] = '\0';
-		memset(_house[i], AlgorithmBase::UNKNOWN, MAXHOUSELENGTH); // fill in all places with unknowns
+	}
+
+	createHouse();
+}
+
+// an unknown MAXHOUSELENGTH x MAXHOUSELENGTH map (rows already allocated) with the robot in the middle
+void AlgorithmBase::createHouse()
+{
+	_houseLength = MAXHOUSELENGTH;
+	_houseHeight = MAXHOUSELENGTH;
+	for (int i = 0; i < _houseHeight; i++)
+	{
+		memset(_house[i], AlgorithmBase::UNKNOWN, _houseLength); // fill in all places with unknowns
 	}
 
 	_robot.location = Point(_houseLength / 2, _houseHeight / 2);
 	_docking = Point(_houseLength / 2, _houseHeight / 2);
 
+	_bitBfs.resize(_houseLength, _houseHeight);
+}
+
+void AlgorithmBase::reset()
+{
+	if (_houseLength != MAXHOUSELENGTH || _houseHeight != MAXHOUSELENGTH)
+	{
+		// the map grew on the last house, back to the initial size
+		freeHouse(_houseHeight);
+		_house = new char*[MAXHOUSELENGTH];
+		for (size_t i = 0; i < MAXHOUSELENGTH; i++)
+		{
+			_house[i] = new char[MAXHOUSELENGTH + 1];
+			_house[i][MAXHOUSELENGTH] = '\0';
+		}
+	}
+
+	_sensor = nullptr;
+	_config.clear();
+	_batteryCapacity = 0;
+	_batteryConsumptionRate = 0;
+	_batteryRechargeRate = 0;
+	_robot = RobotInformation();
+
+	_lastMove = Direction::Stay;
+	_aboutToFinishCalled = false;
+	_movesDone.clear();
+	_movesUntilFinish = 100000000;
+
+	_mode = Mode::SCAN;
+	_prevMode = Mode::SCAN;
+	_NLocations.clear();
+	_dirtyLocations.clear();
+	_undisciplinedCount = 0;
+	_dijakstraToDest.clear();
+	_dijakstraHome.clear();
+
+	createHouse();
 }
 
 void AlgorithmBase::freeHouse(int height)
@@ -38,6 +88,15 @@ AlgorithmBase::~AlgorithmBase()
 	freeHouse(_houseHeight);
 }
 
+void AlgorithmBase::setConfiguration(map<string, int> config)
+{
+	_config = config;
+	_batteryCapacity = _config["BatteryCapacity"];
+	_batteryConsumptionRate = _config["BatteryConsumptionRate"];
+	_batteryRechargeRate = _config["BatteryRechargeRate"];
+	_robot.battery = _batteryCapacity;
+}
+
 void AlgorithmBase::aboutToFinish(int stepsTillFinishing_)
 {
 	_aboutToFinishCalled = true;
@@ -46,67 +105,24 @@ void AlgorithmBase::aboutToFinish(int stepsTillFinishing_)
 	
 void AlgorithmBase::dijakstra(Point dest_, vector<Direction>& result_)
 {
-	queue<Point> queue;
-	set<Point> untouched;
-	map<Point, Direction> map;
-
-	for (int i = 0; i < _houseHeight; ++i)
-	{
-		for (int j = 0; j < _houseLength; ++j)
-		{
-			char block = _house[i][j];
-			if (block != UNKNOWN && block != WALL)
-			{
-				untouched.insert(Point(j, i));
-			}
-		}
-	}
-
-	queue.push(_robot.location);
-	untouched.erase(_robot.location);
-
-	bool foundPath = false;
-	while (!foundPath && queue.size() > 0)
+	if (dest_ == _robot.location)
 	{
-		Point point = queue.front();
-		queue.pop();
-
+		// a queue BFS only notices the destination through one of its neighbours
 		for (int i = 0; i < 4; i++)
 		{
-			Point block = point;
+			Point block = dest_;
 			block.move((Direction)i);
-
-			if (untouched.find(block) != untouched.end())
+			if (_bitBfs.isPassable(block))
 			{
-				untouched.erase(block);
-				queue.push(block);
-				
-				map[block] = ((Direction) i);
-			}
-
-			if (block == dest_)
-			{
-				foundPath = true;
+				result_.clear();
+				return;
 			}
 		}
-	}
-
-	if (!foundPath)
-	{
-		// nothing to do
 		return;
 	}
 
-	// storing path to destination
-	result_.clear();
-	Point p = dest_;
-
-	while (!(p == _robot.location))
-	{
-		Direction dir = map[p];
-		result_.push_back(dir);
-		p.move(oppositeDirection(dir));
-	}
+	// same path a queue BFS (East, West, South, North) finds, stored in reverse
+	_bitBfs.shortestPath(_robot.location, dest_, result_);
 }
 
 int AlgorithmBase::calcScoreForPath(int untilPoint, Point point)
@@ -131,46 +147,44 @@ int AlgorithmBase::calcScoreForPath(int untilPoint, Point point)
 
 void AlgorithmBase::dijakstraHome(Point dest_, vector<Direction>& result_)
 {
+	// I'd like to take a minute to explain all data structures in use (all of them are members, reused between steps):
 
-	// I'd like to take a minute to explain all data structures in use:
+	// Normal dijkstra queue, all items can be here max 1 time (_homeQueue, popped by advancing 'head')
+	// Per block state: not visited yet, in queue, or taken out of the queue / a point we'll not travel to (_homeState)
+	// scoring map, includeing direction which we came from (_homeScore, _homeDirection)
+	enum { UNTOUCHED = 0, IN_QUEUE, DONT_TOUCH };
 
-	// Normal dijkstra queue, all items can be here max 1 time
-	queue<Point> queue;
-	// all items in queue, used for finding in O(1)
-	set<Point> inQueue;
-	// all items that were taken out of the queue, or points we'll not travel to
-	set<Point> dontTouch;
-	// scoring map, includeing direction which we came from
-	map<Point, tuple<int, Direction>> map;
+	size_t area = _houseLength * _houseHeight;
+	_homeState.assign(area, UNTOUCHED);
+	_homeScore.resize(area);
+	_homeDirection.resize(area);
+	_homeQueue.clear();
 
 	for (int i = 0; i < _houseHeight; ++i)
 	{
 		for (int j = 0; j < _houseLength; ++j)
 		{
 			char block = _house[i][j];
-			if (block == UNKNOWN || block == WALL)
-			{
-				dontTouch.insert(Point(j, i));
-			}
-			// dont touch the frame too
-			if (i == 0 || j == 0 || i == _houseHeight - 1 || j == _houseLength - 1)
+			// dont touch walls, '?' and the frame
+			if (block == UNKNOWN || block == WALL || i == 0 || j == 0 || i == _houseHeight - 1 || j == _houseLength - 1)
 			{
-				dontTouch.insert(Point(j, i));
+				_homeState[i * _houseLength + j] = DONT_TOUCH;
 			}
 		}
 	}
 
-	queue.push(_robot.location);
-	inQueue.insert(_robot.location);
-	dontTouch.insert(_robot.location);
+	int robotIndex = _robot.location.getY() * _houseLength + _robot.location.getX();
+	_homeQueue.push_back(_robot.location);
+	_homeState[robotIndex] = DONT_TOUCH;
+	_homeScore[robotIndex] = 0;
+	_homeDirection[robotIndex] = Direction::East;
 
 	bool foundPath = false;
-	while (!foundPath && queue.size() > 0)
+	for (size_t head = 0; !foundPath && head < _homeQueue.size(); ++head)
 	{
-		Point point = queue.front();
-		queue.pop();
-		inQueue.erase(point);
-		dontTouch.insert(point);
+		Point point = _homeQueue[head];
+		int pointIndex = point.getY() * _houseLength + point.getX();
+		_homeState[pointIndex] = DONT_TOUCH;
 
 		if (point == dest_)
 		{
@@ -178,32 +192,31 @@ void AlgorithmBase::dijakstraHome(Point dest_, vector<Direction>& result_)
 			break;
 		}
 		
+		int score = calcScoreForPath(_homeScore[pointIndex], point);
 		for (int i = 0; i < 4; i++)
 		{
 			Point block = point;
 			block.move((Direction)i);
+			int blockIndex = block.getY() * _houseLength + block.getX();
 
-			if (dontTouch.find(block) != dontTouch.end())
+			if (_homeState[blockIndex] == DONT_TOUCH)
 			{
 				// block is a wall, '?', or already computed it's weight
 				continue;
 			}
 
-			if (inQueue.find(block) == inQueue.end())
+			if (_homeState[blockIndex] == UNTOUCHED)
 			{
 				// block is not in queue
-				map[block] = tuple<int, Direction>(calcScoreForPath(std::get<0>(map[point]), point), (Direction)i);
-				queue.push(block);
-				inQueue.insert(block);
+				_homeScore[blockIndex] = score;
+				_homeDirection[blockIndex] = (Direction)i;
+				_homeQueue.push_back(block);
+				_homeState[blockIndex] = IN_QUEUE;
 			}
-			else
+			else if (score < _homeScore[blockIndex])
 			{
-				int score = calcScoreForPath(std::get<0>(map[point]), point);
-				int prevScore = std::get<0>(map[block]);
-				if (score < prevScore)
-				{
-					map[block] = tuple<int, Direction>(score, (Direction)i);
-				}
+				_homeScore[blockIndex] = score;
+				_homeDirection[blockIndex] = (Direction)i;
 			}
 		}
 	}
@@ -220,7 +233,7 @@ void AlgorithmBase::dijakstraHome(Point dest_, vector<Direction>& result_)
 
 	while (!(p == _robot.location))
 	{
-		Direction dir = std::get<1>(map[p]);
+		Direction dir = _homeDirection[p.getY() * _houseLength + p.getX()];
 		result_.push_back(dir);
 		p.move(oppositeDirection(dir));
 	}
@@ -272,6 +285,8 @@ void AlgorithmBase::updatePoints(unsigned int xOffset, unsigned int yOffset)
 
 void AlgorithmBase::expandMatrix()
 {
+	int lengthBefore = _houseLength, heightBefore = _houseHeight;
+
 	if (_robot.location.getY() == _houseHeight -2)
 	{
 		int oldHeight = _houseHeight;
@@ -365,9 +380,15 @@ void AlgorithmBase::expandMatrix()
 
 		updatePoints(oldLength, 0);
 	}
+
+	if (_houseLength != lengthBefore || _houseHeight != heightBefore)
+	{
+		_bitBfs.load(_house, _houseLength, _houseHeight, WALL, UNKNOWN);
+	}
 }
 
-void AlgorithmBase::updateAfterMove(Direction direction_)
+// replayingPlan_ - a planned step (see plan), the home path and the battery checks can't change anything on it
+void AlgorithmBase::updateAfterMove(Direction direction_, bool replayingPlan_)
 {
 	// update robot info
 	_robot.location.move(direction_);
@@ -380,6 +401,13 @@ void AlgorithmBase::updateAfterMove(Direction direction_)
 	_robot.totalSteps++;
 
 	expandMatrix();
+
+	if (replayingPlan_)
+	{
+		updateRemainingMoves();
+		_robot.battery -= _batteryConsumptionRate; // planned steps never end on the docking station
+		return;
+	}
 	
 	dijakstraHome(_docking, _dijakstraHome);
 	updateRemainingMoves();
@@ -387,7 +415,7 @@ void AlgorithmBase::updateAfterMove(Direction direction_)
 	updateBattery();
 }
 
-Direction AlgorithmBase::recoverFromUndisciplinedRobot(Direction actualPrevStep_, SensorInformation info, vector<Direction>& possibleMoves)
+Direction AlgorithmBase::recoverFromUndisciplinedRobot(Direction actualPrevStep_, SensorInformation info, MoveList& possibleMoves)
 {
 	if (actualPrevStep_ == Direction::Stay)
 	{
@@ -438,6 +466,7 @@ void AlgorithmBase::updateHouseKnowladge(SensorInformation info)
 			else
 			{
 				_house[block.getY()][block.getX()] = NOTWALL;
+				_bitBfs.setPassable(block);
 				_NLocations.insert(block);
 			}
 		}
@@ -451,17 +480,20 @@ void AlgorithmBase::updateHouseKnowladge(SensorInformation info)
 
 	_NLocations.erase(_robot.location);
 	_house[_robot.location.getY()][_robot.location.getX()] = (dL == 0) ? EMPTY : CLEAN + dL;
+	_bitBfs.setPassable(_robot.location);
 }
 
 Point AlgorithmBase::findClosestPoint(const set<Point>& points)
 {
 	Point result;
 	int minDistance = 10000000;
+
+	// one BFS gives the distances to all points (an unreachable point counts as 0 - an empty path), on any map size -
+	// a path query per point would cost the number of points times a query
+	_bitBfs.spread(_robot.location);
 	for (auto it = points.begin(); it != points.end(); ++it)
 	{
-		vector<Direction> dirsToPoint;
-		dijakstra(*it, dirsToPoint);
-		int distance = dirsToPoint.size();
+		int distance = std::max(_bitBfs.spreadDistance(*it), 0);
 		if (distance < minDistance)
 		{
 			result = *it;
@@ -473,13 +505,13 @@ Point AlgorithmBase::findClosestPoint(const set<Point>& points)
 
 int AlgorithmBase::GetMovesToPoint(Point point)
 {
-	vector<Direction> directions;
-	dijakstra(point, directions);
+	_scratchPath.clear();
+	dijakstra(point, _scratchPath);
 
-	return directions.size();
+	return _scratchPath.size();
 }
 
-Direction AlgorithmBase::getMoveScanMode(SensorInformation info, vector<Direction>& possiblemoves)
+Direction AlgorithmBase::getMoveScanMode(SensorInformation info, MoveList& possiblemoves)
 {
 	if (info.dirtLevel > 0)
 	{
@@ -566,15 +598,15 @@ Direction AlgorithmBase::getMoveScanMode(SensorInformation info, vector<Directio
 
 size_t AlgorithmBase::movesUntilNoBattery()
 {
-	return (size_t) _robot.battery / _config["BatteryConsumptionRate"];
+	return (size_t) _robot.battery / _batteryConsumptionRate;
 }
 
-Direction AlgorithmBase::getMoveDijakstraMode(vector<Direction>& vector)
+Direction AlgorithmBase::getMoveDijakstraMode(MoveList& possiblemoves)
 {
 	if (_dijakstraToDest.size() > movesUntilNoBattery() )
 	{
 		_mode = RETURNHOME;
-		return getMoveReturnHomeMode(vector);
+		return getMoveReturnHomeMode(possiblemoves);
 	}
 
 	if (_dijakstraToDest.size() == 1)
@@ -588,7 +620,7 @@ Direction AlgorithmBase::getMoveDijakstraMode(vector<Direction>& vector)
 	return dir;
 }
 
-Direction AlgorithmBase::getMoveReturnHomeMode(vector<Direction>& vector)
+Direction AlgorithmBase::getMoveReturnHomeMode(MoveList& possiblemoves)
 {
 	if (_robot.location == _docking)
 	{
@@ -601,20 +633,11 @@ Direction AlgorithmBase::getMoveReturnHomeMode(vector<Direction>& vector)
 	return dir;
 }
 
-Direction AlgorithmBase::getMove(Direction prevStep_, vector<Direction>& order_)
+// possibleMoves - the open directions around the robot, in the algorithm's order
+Direction AlgorithmBase::getMove(Direction prevStep_, SensorInformation info, MoveList& possibleMoves)
 {
-	SensorInformation info = _sensor->sense(); // info.isWall = { East, West, South, North }
 	updateHouseKnowladge(info);
 
-	vector<Direction> possibleMoves;
-	for (auto dir : order_)
-	{
-		if (!info.isWall[(int)dir])
-		{
-			possibleMoves.push_back(dir);
-		}
-	}
-
 	if (prevStep_ != _lastMove)
 	{
 		_undisciplinedCount++;
@@ -645,6 +668,85 @@ Direction AlgorithmBase::getMove(Direction prevStep_, vector<Direction>& order_)
 	return possibleMoves[0];
 }
 
+bool AlgorithmBase::isOnExpansionBorder(const Point& p) const
+{
+	return p.getX() == 1 || p.getY() == 1 || p.getX() == _houseLength - 2 || p.getY() == _houseHeight - 2;
+}
+
+// Offers the rest of a DIJAKSTRA path, cut where step() could have done anything other than popping the next move of it.
+// On the k-th planned step at location l (no docking station, no map expansion on the way):
+//		battery = B - k*c, and the scored path home from l is bounded by D(l) + HOME_PATH_MARGIN, D being the BFS distance
+//		from the docking station on the map known now (it only grows, so distances only get shorter). The undisciplined
+//		rate only gets lower, so updateBattery can't switch to LOWBATTERY while B - k*c - 2*c > (D(l) + margin) * (1 + rate) * c
+//		(one more c is kept for rounding), and getMoveDijakstraMode keeps popping while the path fits in the battery (S + 1 <= B / c).
+// aboutToFinish drops the plan, so the RETURNHOME check can't fire either. _DEBUG_ builds check the replay against step().
+bool AlgorithmBase::plan(MovePlan& plan_)
+{
+	int c = _batteryConsumptionRate;
+	if (_mode != DIJAKSTRA || _aboutToFinishCalled || c <= 0 || _dijakstraToDest.empty())
+	{
+		return false;
+	}
+
+	int battery = _robot.battery;
+	double rate = getUndisciplinedRate();
+	if ((int)_dijakstraToDest.size() + 1 > battery / c)
+	{
+		return false;
+	}
+
+	// the location at the beginning of the first planned step
+	Point location = _robot.location;
+	location.move(_lastMove);
+
+	_bitBfs.spread(_docking);
+	for (auto it = _dijakstraToDest.rbegin(); it != _dijakstraToDest.rend(); ++it)
+	{
+		int k = plan_.moves.size() + 1;
+		int toDocking = _bitBfs.spreadDistance(location);
+		if (location == _docking || isOnExpansionBorder(location) || toDocking < 0
+			|| battery - (k + 3) * c <= (toDocking + HOME_PATH_MARGIN) * (1 + rate) * c)
+		{
+			break;
+		}
+
+		plan_.moves.push_back(*it);
+		location.move(*it);
+	}
+#ifdef _DEBUG_
+	_plannedMoves = plan_.moves;
+#endif
+
+	plan_.batteryThreshold = c; // compared with the battery after the step's cost - one more step has to be paid for
+	plan_.interruptOnDirt = false;
+	plan_.interruptOnAboutToFinish = true;
+	return !plan_.moves.empty();
+}
+
+// the same as step() on each planned move, only the home path is computed just once, for the last one
+void AlgorithmBase::planExecuted(const vector<SensorInformation>& infos_)
+{
+	for (size_t i = 0; i < infos_.size(); ++i)
+	{
+#ifdef _DEBUG_
+		updateAfterMove(_lastMove); // all of step(), its move has to be the planned one
+#else
+		updateAfterMove(_lastMove, i + 1 < infos_.size());
+#endif
+
+		MoveList none; // DIJAKSTRA mode doesn't look at them
+		Direction next = getMove(_lastMove, infos_[i], none);
+#ifdef _DEBUG_
+		if (i < _plannedMoves.size() && next != _plannedMoves[i])
+		{
+			cerr << "plan: step() would have moved " << DirectionToString(next) << " instead of " << DirectionToString(_plannedMoves[i]) << " on planned move " << i << endl;
+			next = _plannedMoves[i];
+		}
+#endif
+		updateBeforeMove(next);
+	}
+}
+
 void AlgorithmBase::printHouse(Point robotLocation) const
 {
 	cout << "####################################################" << endl;
@@ -689,9 +791,9 @@ double AlgorithmBase::getUndisciplinedRate()
 
 void AlgorithmBase::updateBattery()
 {
-	int consumptionRate = _config["BatteryConsumptionRate"];
-	int rechargeRate = _config["BatteryRechargeRate"];
-	int capacity = _config["BatteryCapacity"];
+	int consumptionRate = _batteryConsumptionRate;
+	int rechargeRate = _batteryRechargeRate;
+	int capacity = _batteryCapacity;
 
 	if (isDocking())
 	{
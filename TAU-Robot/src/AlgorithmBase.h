@@ -10,12 +10,19 @@ using namespace std;
 
 #include "Direction.h"
 #include "AbstractAlgorithm.h"
+#include "ResettableAlgorithm.h"
+#include "PlanningAlgorithm.h"
 #include "Configuration.h"
 #include "RobotInformation.h"
+#include "BitBfs.h"
+#include "FixedVector.h"
 
 #define MAXHOUSELENGTH 96
 
-class AlgorithmBase : public AbstractAlgorithm
+// moves added to the BFS distance home when plan() bounds the scored path home of a future step
+#define HOME_PATH_MARGIN 2
+
+class AlgorithmBase : public AbstractAlgorithm, public ResettableAlgorithm, public PlanningAlgorithm
 {
 
 public:
@@ -25,10 +32,13 @@ public:
 	AlgorithmBase(const AbstractSensor& sensor, const Configuration& conf) { setSensor(sensor); setConfiguration(conf.getParams()); }
 
 	void setSensor(const AbstractSensor& sensor) { _sensor = &sensor; }
-	void setConfiguration(map<string, int> config) { _config = config; _robot.battery = _config["BatteryCapacity"]; }
+	void setConfiguration(map<string, int> config);
 
 	virtual Direction step(Direction prevStep) = 0;
 	void aboutToFinish(int stepsTillFinishing);
+	void reset();
+	bool plan(MovePlan& plan_);
+	void planExecuted(const vector<SensorInformation>& infos_);
 	void updateBattery();
 
 protected:
@@ -36,6 +46,11 @@ protected:
 	map<string, int>		_config;
 	RobotInformation		_robot;
 
+	// cached from _config - a lookup by a const char* key builds a temporary string every step
+	int _batteryCapacity = 0;
+	int _batteryConsumptionRate = 0;
+	int _batteryRechargeRate = 0;
+
 	Direction _lastMove = Direction::Stay;
 	bool _aboutToFinishCalled = false;
 	vector<Direction> _movesDone;
@@ -47,6 +62,9 @@ protected:
 	enum { DUST1 = '1', DUST2, DUST3, DUST4, DUST5, DUST6, DUST7, DUST8, DUST9 };
 	enum Mode { RETURNHOME, SCAN, DIJAKSTRA, LOWBATTERY};
 
+	// the moves possible from the current block, in the algorithm's order
+	typedef FixedVector<Direction, 4> MoveList;
+
 	char** _house;
 
 	int _houseLength = MAXHOUSELENGTH;
@@ -64,7 +82,22 @@ protected:
 	// List of dirs to destination.. stored in reverse for convinience
 	vector<Direction> _dijakstraHome;
 
+	// the moves of the last plan, checked against step() on replaying it (_DEBUG_ only)
+	vector<Direction> _plannedMoves;
+
+	// Known passable cells of _house as bitboards - unit cost BFS queries (shortest paths, distances) for derived algorithms too
+	BitBfs _bitBfs;
+
+	// Scratch buffers reused between steps, so a step does not allocate
+	vector<Direction>	_scratchPath;
+	vector<Point>		_homeQueue;
+	vector<int>			_homeScore;
+	vector<Direction>	_homeDirection;
+	vector<char>		_homeState;
+
 
+	void createHouse();
+	bool isOnExpansionBorder(const Point& p) const;
 	bool isDocking() const;
 	static Direction oppositeDirection(Direction direction_);
 	void updateRemainingMoves();
@@ -74,17 +107,17 @@ protected:
 	void updatePointsSet(set<Point>& points, unsigned xOffset, unsigned yOffset);
 	void updatePoints(unsigned xOffset, unsigned yOffset);
 	void expandMatrix();
-	void updateAfterMove(Direction direction_);
-	Direction recoverFromUndisciplinedRobot(Direction prevMove_, SensorInformation info, vector<Direction>& possiblemoves);
+	void updateAfterMove(Direction direction_, bool replayingPlan_ = false);
+	Direction recoverFromUndisciplinedRobot(Direction prevMove_, SensorInformation info, MoveList& possiblemoves);
 	string DirectionToString(Direction direction) const;
 	void updateHouseKnowladge(SensorInformation info);
 	Point findClosestPoint(const set<Point>& points);
 	int GetMovesToPoint(Point point);
-	Direction getMoveScanMode(SensorInformation info, vector<Direction>& possiblemoves);
+	Direction getMoveScanMode(SensorInformation info, MoveList& possiblemoves);
 	size_t movesUntilNoBattery();
-	Direction getMoveDijakstraMode(vector<Direction>& possiblemoves);
-	Direction getMoveReturnHomeMode(vector<Direction>& vector);
-	Direction getMove(Direction prevMove_, vector<Direction>& order);
+	Direction getMoveDijakstraMode(MoveList& possiblemoves);
+	Direction getMoveReturnHomeMode(MoveList& possiblemoves);
+	Direction getMove(Direction prevMove_, SensorInformation info, MoveList& possiblemoves);
 	void printHouse(Point robotLocation) const;
 	void printNLocation();
 	void dijakstra(Point dest_, vector<Direction>& result);
@@ -0,0 +1,43 @@
+#include "AlgorithmPool.h"
+#include "AlgorithmRegistrar.h"
+#include "ResettableAlgorithm.h"
+
+
+map<string, unique_ptr<AbstractAlgorithm>> AlgorithmPool::acquire(map<string, AllocationProfile>* profiles_)
+{
+	AlgorithmRegistrar& registrar = AlgorithmRegistrar::getInstance();
+	map<string, unique_ptr<AbstractAlgorithm>> algorithms;
+
+	vector<string> names = registrar.getAlgorithmNames();
+	for (vector<string>::iterator it = names.begin(); it != names.end(); ++it)
+	{
+		AllocationProfile* profile = (profiles_ != nullptr) ? &(*profiles_)[*it] : nullptr;
+		unique_ptr<AbstractAlgorithm> algo;
+
+		auto idle = _idle.find(*it);
+		if (idle != _idle.end() && idle->second != nullptr)
+		{
+			AllocationCounter::Scope allocations(profile);
+			dynamic_cast<ResettableAlgorithm&>(*idle->second).reset();
+			algo = std::move(idle->second);
+		}
+		else
+		{
+			AllocationCounter::Scope allocations(profile);
+			algo = registrar.createAlgorithm(*it);
+		}
+
+		algorithms[*it] = std::move(algo);
+	}
+
+	return algorithms;
+}
+
+
+void AlgorithmPool::release(const string& name_, unique_ptr<AbstractAlgorithm> algo_)
+{
+	if (algo_ != nullptr && dynamic_cast<ResettableAlgorithm*>(algo_.get()) != nullptr)
+	{
+		_idle[name_] = std::move(algo_);
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef __ALGORITHM_POOL__H_
+#define __ALGORITHM_POOL__H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+#include "Direction.h"
+#include "AbstractAlgorithm.h"
+#include "AllocationCounter.h"
+
+
+// Instances of the registered algorithms kept between houses (one pool per simulation thread).
+// Only algorithms implementing ResettableAlgorithm are kept, the rest are constructed for every house.
+class AlgorithmPool
+{
+	map<string, unique_ptr<AbstractAlgorithm>>	_idle;
+
+public:
+	// an instance of every registered algorithm - a reset one from the pool or a new one.
+	// with profiles_, the allocations of the constructors / resets are charged to the algorithms' profiles
+	map<string, unique_ptr<AbstractAlgorithm>> acquire(map<string, AllocationProfile>* profiles_ = nullptr);
+
+	// gives an instance back after its simulation is done
+	void release(const string& name_, unique_ptr<AbstractAlgorithm> algo_);
+};
+
+
+#endif //__ALGORITHM_POOL__H_
@@ -78,6 +78,20 @@ map<string, unique_ptr<AbstractAlgorithm>> AlgorithmRegistrar::getAlgorithms() c
 }
 
 
+unique_ptr<AbstractAlgorithm> AlgorithmRegistrar::createAlgorithm(const string& name_) const
+{
+	for (vector<AlgoLoaderPair>::const_iterator it = _algorithmPairs.begin(); it != _algorithmPairs.end(); ++it)
+	{
+		if (it->first->getFileName() == name_)
+		{
+			return (it->second)();
+		}
+	}
+
+	return nullptr;
+}
+
+
 vector<string> AlgorithmRegistrar::getAlgorithmNames() const
 {
 	vector<string> names;
@@ -91,6 +105,20 @@ vector<string> AlgorithmRegistrar::getAlgorithmNames() const
 }
 
 
+string AlgorithmRegistrar::getAlgorithmNameAt(const void* address_) const
+{
+	for (vector<AlgoLoaderPair>::const_iterator it = _algorithmPairs.begin(); it != _algorithmPairs.end(); ++it)
+	{
+		if (it->first != nullptr && it->first->contains(address_))
+		{
+			return it->first->getFileName();
+		}
+	}
+
+	return "";
+}
+
+
 void AlgorithmRegistrar::registerAlgorithm(std::function<unique_ptr<AbstractAlgorithm>()> algorithmFactory) {
 	_instance._algorithmPairs.push_back(std::make_pair(nullptr, algorithmFactory));
 }
\ No newline at end of file
@@ -30,7 +30,10 @@ public:
 	
 	int loadAlgorithm(const char* soPath_);
 	map<string, unique_ptr<AbstractAlgorithm>> getAlgorithms() const;
+	unique_ptr<AbstractAlgorithm> createAlgorithm(const string& name_) const;
 	vector<string> getAlgorithmNames() const;
+	// the algorithm whose shared object address_ is in ("" if none)
+	string getAlgorithmNameAt(const void* address_) const;
 	size_t size() const { return _algorithmPairs.size(); }
 	
 	static AlgorithmRegistrar& getInstance() { return _instance; }
@@ -0,0 +1,244 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+
+atomic_bool AllocationCounter::_enabled{ false };
+atomic_bool AllocationCounter::_profiling{ false };
+
+static thread_local size_t allocationsCount = 0;
+static thread_local AllocationProfile* currentProfile = nullptr;
+static atomic<uint64_t> lastProfileId{ 0 };
+
+
+// The blocks allocated inside a Scope, with the profile that made them and their size (-alloc_profile only).
+// Open addressing (linear probing, deletion by shifting back) on malloc'd memory - operator new can't be used here.
+// One lock for all the threads, it's a diagnostic mode.
+class BlockOwners
+{
+	struct Entry
+	{
+		void*		block;	// nullptr = empty
+		uint64_t	owner;
+		size_t		bytes;
+	};
+
+	Entry*	_entries = nullptr;
+	size_t	_capacity = 0;	// a power of 2
+	size_t	_size = 0;
+	mutex	_mutex;
+
+	size_t slotOf(void* block_) const { return (size_t)(((uintptr_t)block_ >> 4) * 0x9E3779B97F4A7C15ull) & (_capacity - 1); }
+
+	void grow()
+	{
+		Entry* old = _entries;
+		size_t oldCapacity = _capacity;
+		_capacity = (_capacity == 0) ? 1024 : 2 * _capacity;
+		_entries = (Entry*)calloc(_capacity, sizeof(Entry));
+		_size = 0;
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (old[i].block != nullptr) insertLocked(old[i].block, old[i].owner, old[i].bytes);
+		}
+		free(old);
+	}
+
+	void insertLocked(void* block_, uint64_t owner_, size_t bytes_)
+	{
+		size_t slot = slotOf(block_);
+		while (_entries[slot].block != nullptr && _entries[slot].block != block_) slot = (slot + 1) & (_capacity - 1);
+		if (_entries[slot].block == nullptr) ++_size;
+		_entries[slot] = Entry{ block_, owner_, bytes_ };
+	}
+
+public:
+	void insert(void* block_, uint64_t owner_, size_t bytes_)
+	{
+		lock_guard<mutex> lock(_mutex);
+		if (2 * (_size + 1) > _capacity) grow();
+		insertLocked(block_, owner_, bytes_);
+	}
+
+	// false if block_ wasn't allocated inside a Scope
+	bool erase(void* block_, uint64_t& owner_, size_t& bytes_)
+	{
+		lock_guard<mutex> lock(_mutex);
+		if (_size == 0) return false;
+
+		size_t slot = slotOf(block_);
+		while (_entries[slot].block != block_)
+		{
+			if (_entries[slot].block == nullptr) return false;
+			slot = (slot + 1) & (_capacity - 1);
+		}
+		owner_ = _entries[slot].owner;
+		bytes_ = _entries[slot].bytes;
+		--_size;
+
+		// move back the entries after it that would be cut off from their slot
+		size_t hole = slot;
+		for (size_t next = (slot + 1) & (_capacity - 1); _entries[next].block != nullptr; next = (next + 1) & (_capacity - 1))
+		{
+			size_t home = slotOf(_entries[next].block);
+			bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+			if (movable)
+			{
+				_entries[hole] = _entries[next];
+				hole = next;
+			}
+		}
+		_entries[hole].block = nullptr;
+		return true;
+	}
+};
+
+static BlockOwners blockOwners;
+
+
+uint64_t AllocationProfile::nextId()
+{
+	return ++lastProfileId;
+}
+
+
+static size_t usableSize(void* p_)
+{
+#if defined(__GLIBC__)
+	return malloc_usable_size(p_);
+#elif defined(_WINDOWS_)
+	return _msize(p_);
+#else
+	return 0;	// only the allocations are counted
+#endif
+}
+
+
+void AllocationProfile::append(const AllocationProfile& later_)
+{
+	allocations += later_.allocations;
+	bytes += later_.bytes;
+	if (live + later_.peak > peak) peak = live + later_.peak;
+	live += later_.live;
+}
+
+
+void AllocationProfile::merge(const AllocationProfile& other_)
+{
+	allocations += other_.allocations;
+	bytes += other_.bytes;
+	live += other_.live;
+	if (other_.peak > peak) peak = other_.peak;
+}
+
+
+AllocationCounter::Scope::Scope(AllocationProfile* profile_) : _previous(currentProfile), _set(profile_ != nullptr)
+{
+	if (_set)
+	{
+		currentProfile = profile_;
+	}
+}
+
+
+AllocationCounter::Scope::~Scope()
+{
+	if (_set)
+	{
+		currentProfile = _previous;
+	}
+}
+
+
+size_t AllocationCounter::count()
+{
+	return allocationsCount;
+}
+
+
+void AllocationCounter::onAllocation(void* p_)
+{
+	if (_enabled.load(memory_order_relaxed))
+	{
+		++allocationsCount;
+	}
+
+	if (currentProfile != nullptr)
+	{
+		size_t bytes = usableSize(p_);
+		currentProfile->onAllocation(bytes);
+		blockOwners.insert(p_, currentProfile->id, bytes);
+	}
+}
+
+
+void AllocationCounter::onFree(void* p_)
+{
+	uint64_t owner;
+	size_t bytes;
+	if (p_ != nullptr && _profiling.load(memory_order_relaxed) && blockOwners.erase(p_, owner, bytes))
+	{
+		if (currentProfile != nullptr && currentProfile->id == owner)
+		{
+			currentProfile->onFree(bytes);
+		}
+	}
+}
+
+
+static void release(void* p_)
+{
+	AllocationCounter::onFree(p_);
+	free(p_);
+}
+
+
+static void* allocate(size_t size_)
+{
+	void* p = malloc(size_ == 0 ? 1 : size_);
+	while (p == nullptr)
+	{
+		new_handler handler = get_new_handler();
+		if (handler == nullptr)
+		{
+			throw bad_alloc();
+		}
+		handler();
+		p = malloc(size_ == 0 ? 1 : size_);
+	}
+
+	AllocationCounter::onAllocation(p);
+	return p;
+}
+
+
+static void* allocate(size_t size_, const nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size_);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+
+void* operator new(size_t size_) { return allocate(size_); }
+void* operator new[](size_t size_) { return allocate(size_); }
+void* operator new(size_t size_, const nothrow_t& tag_) noexcept { return allocate(size_, tag_); }
+void* operator new[](size_t size_, const nothrow_t& tag_) noexcept { return allocate(size_, tag_); }
+
+void operator delete(void* p_) noexcept { release(p_); }
+void operator delete[](void* p_) noexcept { release(p_); }
+void operator delete(void* p_, const nothrow_t&) noexcept { release(p_); }
+void operator delete[](void* p_, const nothrow_t&) noexcept { release(p_); }
+void operator delete(void* p_, size_t) noexcept { release(p_); }
+void operator delete[](void* p_, size_t) noexcept { release(p_); }
@@ -0,0 +1,87 @@
+#ifndef __ALLOCATION_COUNTER__H_
+#define __ALLOCATION_COUNTER__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+
+// allocations made by a number of steps
+struct AllocationStats
+{
+	size_t	steps = 0;
+	size_t	total = 0;
+	size_t	max = 0;
+
+	void addStep(size_t allocations_) { ++steps; total += allocations_; if (allocations_ > max) max = allocations_; }
+	void merge(const AllocationStats& other_) { steps += other_.steps; total += other_.total; if (other_.max > max) max = other_.max; }
+	double average() const { return steps > 0 ? (double)total / steps : 0.0; }
+};
+
+
+// heap use of an algorithm (on a house) - what it allocated inside its own calls, and what of that it freed inside them.
+// Only operator new / delete are seen - malloc, strdup etc. in the algorithms aren't counted.
+struct AllocationProfile
+{
+	size_t	allocations = 0;
+	size_t	bytes = 0;		// allocated in total (usable size of the blocks, where the allocator tells it)
+	int64_t	live = 0;		// allocated - freed
+	int64_t	peak = 0;		// max live
+	uint64_t	id = nextId();	// the blocks' owner - a free is only charged to the profile that made the block
+
+	static uint64_t nextId();
+
+	void onAllocation(size_t bytes_) { ++allocations; bytes += bytes_; live += bytes_; if (live > peak) peak = live; }
+	void onFree(size_t bytes_) { live -= bytes_; }
+
+	// this profile goes on after earlier_ (appended to it later) - the blocks earlier_ made are freed into this one
+	void continueFrom(const AllocationProfile& earlier_) { id = earlier_.id; }
+
+	// later_ happened after this (e.g. a simulation after its algorithm's setup)
+	void append(const AllocationProfile& later_);
+	// other_ is unrelated (e.g. another house) - totals add up, the peak is the larger one
+	void merge(const AllocationProfile& other_);
+};
+
+
+// Counts heap allocations (global operator new is replaced in AllocationCounter.cpp).
+// The simulator is linked with -rdynamic, so allocations made inside the algorithm .so files are counted too.
+// Counting is off unless enable() was called (-alloc_count), the counter is per thread.
+// Profiles (-alloc_profile) are charged with the allocations of the calling thread inside a Scope, and with the frees of
+// those blocks inside a Scope of the same profile. A block freed anywhere else (another profile, outside any Scope, another
+// thread) stays live in its profile, and blocks allocated outside a Scope are never charged.
+class AllocationCounter
+{
+	static atomic_bool	_enabled;
+	static atomic_bool	_profiling;
+
+public:
+	static void enable() { _enabled = true; }
+	static bool isEnabled() { return _enabled; }
+	static void enableProfiling() { _profiling = true; }
+	static bool isProfiling() { return _profiling; }
+
+	// allocations made by the calling thread so far
+	static size_t count();
+	static void onAllocation(void* p_);
+	static void onFree(void* p_);
+
+	// the calling thread's allocations go to profile_ till the end of the scope (nothing happens with nullptr)
+	class Scope
+	{
+		AllocationProfile*	_previous;
+		bool				_set;
+
+	public:
+		explicit Scope(AllocationProfile* profile_);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+};
+
+
+#endif //__ALLOCATION_COUNTER__H_
@@ -0,0 +1,156 @@
+#include "Benchmark.h"
+#include "StringUtils.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WINDOWS_
+#include <sys/resource.h>
+#endif
+
+
+long BenchmarkReport::peakRss()
+{
+#ifndef _WINDOWS_
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		return usage.ru_maxrss; // KB on Linux
+	}
+#endif
+	return 0;
+}
+
+
+// median over the runs of get_(run)
+template <class Get>
+double BenchmarkReport::median(Get get_) const
+{
+	vector<double> values;
+	for (const BenchmarkRun& run : runs)
+	{
+		values.push_back(get_(run));
+	}
+	if (values.empty()) return 0.0;
+
+	sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return (values.size() % 2 == 1) ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+
+double BenchmarkReport::overallMean() const
+{
+	double sum = 0.0;
+	for (const BenchmarkRun& run : runs)
+	{
+		sum += run.overall.perSecond();
+	}
+	return runs.empty() ? 0.0 : sum / runs.size();
+}
+
+
+double BenchmarkReport::overallVariance() const
+{
+	if (runs.size() < 2) return 0.0;
+
+	double mean = overallMean(), sum = 0.0;
+	for (const BenchmarkRun& run : runs)
+	{
+		sum += (run.overall.perSecond() - mean) * (run.overall.perSecond() - mean);
+	}
+	return sum / (runs.size() - 1);
+}
+
+
+void BenchmarkReport::print() const
+{
+	if (runs.empty()) return;
+	const BenchmarkRun& first = runs.front();
+
+	cout << "Benchmark: " << runs.size() << " runs, " << houseNames.size() << " houses, " << first.algorithms.size() << " algorithms, " << first.threads.size() << " threads" << endl;
+
+	cout << endl << "Setup:" << endl;
+	printf("%-24s %10.3f ms\n", "houses (read, validate)", housesLoadTime / 1e6);
+	printf("%-24s %10.3f ms\n", "algorithms (dlopen)", algorithmsLoadTime / 1e6);
+	printf("%-24s %10.3f ms (median per run)\n", "algorithms (construct)", median([](const BenchmarkRun& run) { return run.constructionTime / 1e6; }));
+
+	double mean = overallMean();
+	cout << endl << "Steps per second (median of the runs):" << endl;
+	printf("%-13s %12.0f (mean %.0f, variance %.4g, stddev %.2f%%)\n", "overall", median([](const BenchmarkRun& run) { return run.overall.perSecond(); }),
+		mean, overallVariance(), mean > 0 ? 100.0 * sqrt(overallVariance()) / mean : 0.0);
+
+	cout << "per algorithm (time in its own calls):" << endl;
+	for (auto it = first.algorithms.cbegin(); it != first.algorithms.cend(); ++it)
+	{
+		const string& name = it->first;
+		printf("  %-11s %12.0f\n", name.c_str(), median([&name](const BenchmarkRun& run) { return run.algorithms.at(name).perSecond(); }));
+	}
+
+	cout << "per house:" << endl;
+	for (size_t i = 0; i < houseNames.size(); ++i)
+	{
+		printf("  %-11s %12.0f\n", houseNames[i].c_str(), median([i](const BenchmarkRun& run) { return run.houses[i].perSecond(); }));
+	}
+
+	cout << "per thread:" << endl;
+	for (size_t i = 0; i < first.threads.size(); ++i)
+	{
+		printf("  %-11zu %12.0f\n", i + 1, median([i](const BenchmarkRun& run) { return run.threads[i].perSecond(); }));
+	}
+
+	cout << endl << "Peak RSS: " << peakRss() << " KB" << endl;
+}
+
+
+bool BenchmarkReport::writeJson(const string& path_) const
+{
+	ofstream out(path_);
+	if (!out.is_open()) return false;
+
+	auto throughput = [&out](const Throughput& t) {
+		out << "\"steps\": " << t.steps << ", \"ns\": " << t.nanoseconds << ", \"steps_per_second\": " << (uint64_t)t.perSecond();
+	};
+
+	out << "{" << endl;
+	out << "  \"setup\": { \"houses_ns\": " << housesLoadTime << ", \"algorithms_dlopen_ns\": " << algorithmsLoadTime << " }," << endl;
+	out << "  \"peak_rss_kb\": " << peakRss() << "," << endl;
+	out << "  \"steps_per_second\": { \"median\": " << (uint64_t)median([](const BenchmarkRun& run) { return run.overall.perSecond(); })
+		<< ", \"mean\": " << (uint64_t)overallMean() << ", \"variance\": " << overallVariance() << " }," << endl;
+
+	out << "  \"runs\": [";
+	for (size_t r = 0; r < runs.size(); ++r)
+	{
+		const BenchmarkRun& run = runs[r];
+		out << (r == 0 ? "" : ",") << endl << "    { ";
+		throughput(run.overall);
+		out << ", \"construction_ns\": " << run.constructionTime << "," << endl << "      \"algorithms\": [";
+		for (auto it = run.algorithms.cbegin(); it != run.algorithms.cend(); ++it)
+		{
+			out << (it == run.algorithms.cbegin() ? "" : ",") << endl << "        { \"name\": \"" << StringUtils::jsonEscape(it->first) << "\", ";
+			throughput(it->second);
+			out << " }";
+		}
+		out << " ]," << endl << "      \"houses\": [";
+		for (size_t i = 0; i < run.houses.size(); ++i)
+		{
+			out << (i == 0 ? "" : ",") << endl << "        { \"name\": \"" << StringUtils::jsonEscape(houseNames[i]) << "\", ";
+			throughput(run.houses[i]);
+			out << " }";
+		}
+		out << " ]," << endl << "      \"threads\": [";
+		for (size_t i = 0; i < run.threads.size(); ++i)
+		{
+			out << (i == 0 ? "" : ",") << endl << "        { ";
+			throughput(run.threads[i]);
+			out << " }";
+		}
+		out << " ] }";
+	}
+	out << " ]" << endl << "}" << endl;
+
+	return out.good();
+}
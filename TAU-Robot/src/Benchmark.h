@@ -0,0 +1,59 @@
+#ifndef __BENCHMARK__H_
+#define __BENCHMARK__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// steps simulated in some time
+struct Throughput
+{
+	uint64_t	steps = 0;
+	uint64_t	nanoseconds = 0;
+
+	void add(uint64_t steps_, uint64_t nanoseconds_) { steps += steps_; nanoseconds += nanoseconds_; }
+	double perSecond() const { return nanoseconds > 0 ? steps * 1e9 / nanoseconds : 0.0; }
+};
+
+
+// one run of the tournament
+struct BenchmarkRun
+{
+	Throughput				overall;				// all the steps, wall time of the run
+	map<string, Throughput>	algorithms;				// the algorithm's steps, time in its own calls
+	vector<Throughput>		houses;					// all the algorithms' steps on the house, its wall time
+	vector<Throughput>		threads;				// steps of the thread's houses, its wall time
+	uint64_t				constructionTime = 0;	// ns, constructing / resetting the algorithms (all threads)
+};
+
+
+// Repeated runs of the tournament with the output suppressed (-benchmark) - medians of the runs, the variance of the
+// overall steps per second, setup times and the peak RSS. Steps are the algorithms' steps (one per algorithm per step).
+class BenchmarkReport
+{
+public:
+	uint64_t				housesLoadTime = 0;		// ns, reading and validating the houses
+	uint64_t				algorithmsLoadTime = 0;	// ns, dlopen (and registration) of the algorithms
+	vector<string>			houseNames;
+	vector<BenchmarkRun>	runs;
+
+	void print() const;
+	bool writeJson(const string& path_) const;
+
+	// of the process so far (KB, 0 where unknown)
+	static long peakRss();
+
+private:
+	template <class Get>
+	double median(Get get_) const;
+	double overallMean() const;
+	double overallVariance() const;
+};
+
+
+#endif //__BENCHMARK__H_
@@ -0,0 +1,241 @@
+#include "BitBfs.h"
+
+#include <algorithm>
+
+#if !defined(_WINDOWS_) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITBFS_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+	typedef void(*ExpandRow)(const uint64_t* up, const uint64_t* cur, const uint64_t* down, const uint64_t* passable, uint64_t* visited, uint64_t* next, int words);
+
+	// next = (cur | cur moved 1 cell east/west/south/north) & passable & ~visited, then visited |= next
+	// rows have a zero guard word on each side, so cur[w - 1] and cur[w + 1] are always readable
+	void expandRowFrom(int w, const uint64_t* up, const uint64_t* cur, const uint64_t* down, const uint64_t* passable, uint64_t* visited, uint64_t* next, int words)
+	{
+		for (; w <= words; ++w)
+		{
+			uint64_t c = cur[w];
+			uint64_t n = c | (c << 1) | (cur[w - 1] >> 63) | (c >> 1) | (cur[w + 1] << 63) | up[w] | down[w];
+			n &= passable[w] & ~visited[w];
+			next[w] = n;
+			visited[w] |= n;
+		}
+	}
+
+	void expandRowScalar(const uint64_t* up, const uint64_t* cur, const uint64_t* down, const uint64_t* passable, uint64_t* visited, uint64_t* next, int words)
+	{
+		expandRowFrom(1, up, cur, down, passable, visited, next, words);
+	}
+
+#ifdef BITBFS_AVX2
+	__attribute__((target("avx2")))
+	void expandRowAvx2(const uint64_t* up, const uint64_t* cur, const uint64_t* down, const uint64_t* passable, uint64_t* visited, uint64_t* next, int words)
+	{
+		int w = 1;
+		for (; w + 3 <= words; w += 4)
+		{
+			__m256i c = _mm256_loadu_si256((const __m256i*)(cur + w));
+			__m256i left = _mm256_loadu_si256((const __m256i*)(cur + w - 1));
+			__m256i right = _mm256_loadu_si256((const __m256i*)(cur + w + 1));
+
+			__m256i n = _mm256_or_si256(c, _mm256_slli_epi64(c, 1));
+			n = _mm256_or_si256(n, _mm256_srli_epi64(left, 63));
+			n = _mm256_or_si256(n, _mm256_srli_epi64(c, 1));
+			n = _mm256_or_si256(n, _mm256_slli_epi64(right, 63));
+			n = _mm256_or_si256(n, _mm256_loadu_si256((const __m256i*)(up + w)));
+			n = _mm256_or_si256(n, _mm256_loadu_si256((const __m256i*)(down + w)));
+
+			__m256i v = _mm256_loadu_si256((const __m256i*)(visited + w));
+			n = _mm256_andnot_si256(v, _mm256_and_si256(n, _mm256_loadu_si256((const __m256i*)(passable + w))));
+
+			_mm256_storeu_si256((__m256i*)(next + w), n);
+			_mm256_storeu_si256((__m256i*)(visited + w), _mm256_or_si256(v, n));
+		}
+		expandRowFrom(w, up, cur, down, passable, visited, next, words);
+	}
+#endif
+
+	ExpandRow chooseExpandRow()
+	{
+#ifdef BITBFS_AVX2
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return expandRowAvx2;
+		}
+#endif
+		return expandRowScalar;
+	}
+
+	const ExpandRow expandRow = chooseExpandRow();
+
+	int lowestBit(uint64_t bits)
+	{
+#ifdef __GNUC__
+		return __builtin_ctzll(bits);
+#else
+		int i = 0;
+		while (!(bits & 1)) { bits >>= 1; ++i; }
+		return i;
+#endif
+	}
+}
+
+
+void BitBfs::resize(int length_, int height_)
+{
+	_length = length_;
+	_height = height_;
+	_words = (_length + 63) / 64;
+	_stride = _words + 2;
+
+	size_t size = (_height + 2) * _stride;
+	_passable.assign(size, 0);
+	_visited.assign(size, 0);
+	_frontier.assign(size, 0);
+	_next.assign(size, 0);
+	_distance.resize(_length * _height);
+}
+
+
+void BitBfs::load(const char* const* grid_, int length_, int height_, char wall_, char unknown_)
+{
+	resize(length_, height_);
+	for (int y = 0; y < _height; ++y)
+	{
+		uint64_t* bits = row(_passable, y);
+		for (int x = 0; x < _length; ++x)
+		{
+			if (grid_[y][x] != wall_ && grid_[y][x] != unknown_)
+			{
+				bits[1 + x / 64] |= (uint64_t)1 << (x % 64);
+			}
+		}
+	}
+}
+
+
+void BitBfs::setPassable(const Point& p_, bool passable_)
+{
+	if (!isInside(p_)) return;
+
+	uint64_t& word = row(_passable, p_.getY())[1 + p_.getX() / 64];
+	uint64_t bit = (uint64_t)1 << (p_.getX() % 64);
+	word = passable_ ? (word | bit) : (word & ~bit);
+}
+
+
+bool BitBfs::isPassable(const Point& p_) const
+{
+	return isInside(p_) && test(_passable, p_);
+}
+
+
+int BitBfs::run(const Point& from, const Point* stop)
+{
+	std::fill(_visited.begin(), _visited.end(), 0);
+
+	int layer = 0, top = from.getY(), bottom = from.getY();
+	row(_frontier, from.getY())[1 + from.getX() / 64] = (uint64_t)1 << (from.getX() % 64);
+	row(_visited, from.getY())[1 + from.getX() / 64] = (uint64_t)1 << (from.getX() % 64);
+	_distance[from.getY() * _length + from.getX()] = 0;
+
+	int result = (stop != nullptr && *stop == from) ? 0 : -1;
+	while (result < 0 && top <= bottom)
+	{
+		++layer;
+		int first = std::max(top - 1, 0), last = std::min(bottom + 1, _height - 1);
+		int newTop = _height, newBottom = -1;
+
+		for (int y = first; y <= last; ++y)
+		{
+			uint64_t* next = row(_next, y);
+			expandRow(row(_frontier, y - 1), row(_frontier, y), row(_frontier, y + 1), row(_passable, y), row(_visited, y), next, _words);
+
+			for (int w = 1; w <= _words; ++w)
+			{
+				for (uint64_t bits = next[w]; bits != 0; bits &= bits - 1)
+				{
+					_distance[y * _length + (w - 1) * 64 + lowestBit(bits)] = layer;
+					newTop = std::min(newTop, y);
+					newBottom = std::max(newBottom, y);
+				}
+			}
+		}
+
+		// clear the old frontier so it can be reused as the next layer
+		for (int y = top; y <= bottom; ++y)
+		{
+			std::fill(row(_frontier, y), row(_frontier, y) + _stride, 0);
+		}
+		std::swap(_frontier, _next);
+		top = newTop;
+		bottom = newBottom;
+
+		if (stop != nullptr && test(_visited, *stop))
+		{
+			result = layer;
+		}
+	}
+
+	// leave the layer buffers zeroed for the next run (_next already is)
+	for (int y = top; y <= bottom; ++y)
+	{
+		std::fill(row(_frontier, y), row(_frontier, y) + _stride, 0);
+	}
+
+	return result;
+}
+
+
+bool BitBfs::shortestPath(const Point& from_, const Point& to_, vector<Direction>& result_)
+{
+	if (!isInside(from_) || !isInside(to_)) return false;
+
+	// BFS backwards from the destination, then walk forward always taking the first direction that stays on a shortest path
+	int distance = run(to_, &from_);
+	if (distance < 0)
+	{
+		return false;
+	}
+
+	result_.assign(distance, Direction::Stay);
+	Point p = from_;
+	for (int left = distance; left > 0; --left)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			Point block = p;
+			block.move((Direction)i);
+
+			if (isInside(block) && test(_visited, block) && _distance[block.getY() * _length + block.getX()] == left - 1)
+			{
+				result_[left - 1] = (Direction)i;
+				p = block;
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void BitBfs::spread(const Point& from_)
+{
+	if (!isInside(from_)) return;
+	run(from_, nullptr);
+}
+
+
+int BitBfs::spreadDistance(const Point& p_) const
+{
+	if (!isInside(p_) || !test(_visited, p_))
+	{
+		return -1;
+	}
+	return _distance[p_.getY() * _length + p_.getX()];
+}
@@ -0,0 +1,55 @@
+#ifndef __BIT_BFS__H_
+#define __BIT_BFS__H_
+
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+#include "Direction.h"
+#include "Point.h"
+
+
+// Unit cost BFS over a grid map kept as row bitboards (1 bit per cell, 1 = passable).
+// Each BFS layer is expanded 64 cells at a time with shifts and ands (256 at a time with AVX2 when the CPU has it),
+// only the cell distances are written one by one.
+// Paths are the same ones a queue based BFS expanding East, West, South, North (in that order) builds,
+// i.e. the lexicographically smallest of the shortest paths.
+class BitBfs
+{
+	int		_length = 0;
+	int		_height = 0;
+	int		_words = 0;		// words per row, without the guard words
+	int		_stride = 0;	// words per row, including a zero guard word on each side
+
+	// (height + 2) x stride, with a zero guard row above and below the map
+	vector<uint64_t>	_passable;
+	vector<uint64_t>	_visited;
+	vector<uint64_t>	_frontier;
+	vector<uint64_t>	_next;
+	vector<int>			_distance;	// valid for visited cells only
+
+public:
+	void resize(int length_, int height_);
+	void load(const char* const* grid_, int length_, int height_, char wall_, char unknown_);
+	void setPassable(const Point& p_, bool passable_ = true);
+	bool isPassable(const Point& p_) const;
+
+	// Shortest path from -> to. result_ is stored in reverse (last move first), and left untouched if there's no path.
+	bool shortestPath(const Point& from_, const Point& to_, vector<Direction>& result_);
+
+	// Distances from 'from_' to every reachable cell, read back with spreadDistance (-1 = unreachable)
+	void spread(const Point& from_);
+	int spreadDistance(const Point& p_) const;
+
+private:
+	bool isInside(const Point& p) const { return (p.getX() >= 0) && (p.getY() >= 0) && (p.getX() < _length) && (p.getY() < _height); }
+	uint64_t* row(vector<uint64_t>& board, int y) { return &board[(y + 1) * _stride]; }
+	const uint64_t* row(const vector<uint64_t>& board, int y) const { return &board[(y + 1) * _stride]; }
+	bool test(const vector<uint64_t>& board, const Point& p) const { return ((row(board, p.getY())[1 + p.getX() / 64] >> (p.getX() % 64)) & 1) != 0; }
+
+	// Runs the BFS layers from 'from', stops once 'stop' is reached (if given). Returns the distance to 'stop' or -1.
+	int run(const Point& from, const Point* stop);
+};
+
+
+#endif //__BIT_BFS__H_
@@ -0,0 +1,64 @@
+#ifndef __BOUNDED_QUEUE__H_
+#define __BOUNDED_QUEUE__H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+
+
+// A queue of at most capacity items between producer and consumer threads - push waits while it's full, pop waits
+// while it's empty. After close() pushes are dropped and pops return what's left, then false.
+template <class T>
+class BoundedQueue
+{
+	deque<T>			_items;
+	size_t				_capacity;
+	bool				_closed = false;
+	mutex				_mutex;		// a std::mutex, for the condition variables
+	condition_variable	_notFull;
+	condition_variable	_notEmpty;
+
+public:
+	explicit BoundedQueue(size_t capacity_) : _capacity(capacity_ > 0 ? capacity_ : 1) {}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// false if the queue was closed
+	bool push(const T& item_)
+	{
+		unique_lock<mutex> lock(_mutex);
+		_notFull.wait(lock, [this]() { return _closed || _items.size() < _capacity; });
+		if (_closed) return false;
+
+		_items.push_back(item_);
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	// false once the queue is closed and empty
+	bool pop(T& item_)
+	{
+		unique_lock<mutex> lock(_mutex);
+		_notEmpty.wait(lock, [this]() { return _closed || !_items.empty(); });
+		if (_items.empty()) return false;
+
+		item_ = _items.front();
+		_items.pop_front();
+		_notFull.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		lock_guard<mutex> lock(_mutex);
+		_closed = true;
+		_notFull.notify_all();
+		_notEmpty.notify_all();
+	}
+};
+
+
+#endif //__BOUNDED_QUEUE__H_
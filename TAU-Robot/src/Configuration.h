@@ -34,6 +34,7 @@ public:
 	int& operator[](const char* key) { return _params[key]; }
 	const int operator[](const string& key) const { return _params.at(key); }
 	const int operator[](const char* key) const { return _params.at(key); }
+	int get(const char* key, int default_) const { auto it = _params.find(key); return (it != _params.end()) ? it->second : default_; }
 	Configuration& operator=(const Configuration& other) { _params = other._params; _successful = other._successful; return *this; }
 
 	string toString() const;
@@ -0,0 +1,38 @@
+#ifndef __FIXED_VECTOR__H_
+#define __FIXED_VECTOR__H_
+
+#include <cstddef>
+
+
+// vector-like container with its storage inline (no heap allocation), holds up to N elements
+template <class T, size_t N>
+class FixedVector
+{
+	T		_items[N];
+	size_t	_size = 0;
+
+public:
+	typedef T*			iterator;
+	typedef const T*	const_iterator;
+
+	void push_back(const T& val) { _items[_size++] = val; }
+	void pop_back() { --_size; }
+	void clear() { _size = 0; }
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+	static size_t capacity() { return N; }
+
+	T& operator[](size_t i) { return _items[i]; }
+	const T& operator[](size_t i) const { return _items[i]; }
+	T& back() { return _items[_size - 1]; }
+	const T& back() const { return _items[_size - 1]; }
+
+	iterator begin() { return _items; }
+	iterator end() { return _items + _size; }
+	const_iterator begin() const { return _items; }
+	const_iterator end() const { return _items + _size; }
+};
+
+
+#endif //__FIXED_VECTOR__H_
@@ -1,14 +1,128 @@
 #include "House.h"
 #include "BoostUtils.h"
 
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <cmath>
 #include <functional>
 #include <algorithm>
-#include <fstream>
 #include <sstream>
 #include <boost/filesystem.hpp>
 
+#if !defined(_WINDOWS_) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HOUSE_AVX2
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+	// the line at position_ (without its '\n') and position_ moves past it - the way getline reads, empty past the end
+	const char* nextLine(const char*& position_, const char* end_, size_t& length_)
+	{
+		const char* line = position_;
+		const char* newline = (position_ < end_) ? (const char*)memchr(position_, '\n', end_ - position_) : nullptr;
+		length_ = (newline != nullptr ? newline : end_) - line;
+		position_ = (newline != nullptr) ? newline + 1 : end_;
+		return line;
+	}
+
+
+	// what the inside cells of a row add up to
+	struct RowScan
+	{
+		int		dirt = 0;
+		int		dockingCount = 0;
+		size_t	lastDocking = 0;	// column, with dockingCount > 0
+	};
+
+	typedef void(*ScanRow)(char* row_, size_t from_, size_t to_, RowScan& scan_);
+
+	// '0' cells become ' ', dirt is summed, docking stations are counted
+	void scanRowFrom(char* row_, size_t from_, size_t to_, RowScan& scan_)
+	{
+		for (size_t j = from_; j < to_; ++j)
+		{
+			char& curr = row_[j];
+			if (curr == House::CLEAN)
+			{
+				curr = House::EMPTY; // convert '0' dirt chars into ' ' chars
+			}
+			else if (curr >= House::DUST1 && curr <= House::DUST9)
+			{
+				scan_.dirt += curr - House::CLEAN;
+			}
+			else if (curr == House::DOCKING)
+			{
+				scan_.dockingCount++;
+				scan_.lastDocking = j;
+			}
+		}
+	}
+
+#ifdef HOUSE_AVX2
+	// 32 cells at a time, the rest as scanRowFrom
+	__attribute__((target("avx2")))
+	void scanRowAvx2(char* row_, size_t from_, size_t to_, RowScan& scan_)
+	{
+		const __m256i clean = _mm256_set1_epi8(House::CLEAN);
+		const __m256i empty = _mm256_set1_epi8(House::EMPTY);
+		const __m256i dust1 = _mm256_set1_epi8(House::DUST1);
+		const __m256i docking = _mm256_set1_epi8(House::DOCKING);
+		const __m256i eight = _mm256_set1_epi8(8);
+		const __m256i one = _mm256_set1_epi8(1);
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i dirt = zero;
+
+		size_t j = from_;
+		for (; j + 32 <= to_; j += 32)
+		{
+			__m256i cells = _mm256_loadu_si256((const __m256i*)(row_ + j));
+
+			__m256i isClean = _mm256_cmpeq_epi8(cells, clean);
+			if (!_mm256_testz_si256(isClean, isClean))
+			{
+				cells = _mm256_blendv_epi8(cells, empty, isClean);
+				_mm256_storeu_si256((__m256i*)(row_ + j), cells);
+			}
+
+			// '1'..'9' - 0..8 after subtracting '1' (as unsigned bytes, everything else is above 8)
+			__m256i level = _mm256_sub_epi8(cells, dust1);
+			__m256i isDust = _mm256_cmpeq_epi8(_mm256_min_epu8(level, eight), level);
+			dirt = _mm256_add_epi64(dirt, _mm256_sad_epu8(_mm256_and_si256(_mm256_add_epi8(level, one), isDust), zero));
+
+			unsigned dockings = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(cells, docking));
+			if (dockings != 0)
+			{
+				scan_.dockingCount += __builtin_popcount(dockings);
+				scan_.lastDocking = j + 31 - __builtin_clz(dockings);
+			}
+		}
+
+		uint64_t sums[4];
+		_mm256_storeu_si256((__m256i*)sums, dirt);
+		scan_.dirt += (int)(sums[0] + sums[1] + sums[2] + sums[3]);
+		scanRowFrom(row_, j, to_, scan_);
+	}
+#endif
+
+	ScanRow chooseScanRow()
+	{
+#ifdef HOUSE_AVX2
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return scanRowAvx2;
+		}
+#endif
+		return scanRowFrom;
+	}
+
+	const ScanRow scanRow = chooseScanRow();
+}
+
 
 House::House(const char* path_)
 {
@@ -24,12 +138,60 @@ House::House(const char* path_)
 }
 
 
+House::House(const string& name_, size_t maxSteps_, const vector<string>& rows_) : _maxSteps(maxSteps_), _rows(rows_.size()), _cols(0), _name(name_), _totalDirt(0), _currentDirt(0)
+{
+	_houseFilename = name_ + ".house";
+	_houseFilenameWithoutSuffix = name_;
+
+	for (const string& row : rows_)
+	{
+		_cols = std::max(_cols, row.size());
+	}
+
+	if (_rows == 0 || _cols == 0 || _maxSteps == 0)
+	{
+		_isValid = false;
+		_errorLine = _houseFilename + ": empty house";
+		return;
+	}
+
+	_house = new char*[_rows];
+	for (size_t i = 0; i < _rows; i++)
+	{
+		_house[i] = new char[_cols + 1];
+		_house[i][_cols] = '\0';
+		memset(_house[i], House::EMPTY, _cols); // short rows are filled with spaces
+		memcpy(_house[i], rows_[i].c_str(), rows_[i].size());
+	}
+
+	this->validateHouse();
+}
+
+
+House::House(const string& name_, const string& filenameWithoutSuffix_, size_t maxSteps_, size_t rows_, size_t cols_, const char* cells_,
+	const int* dockingDistance_, const Point& docking_, int totalDirt_)
+	: _maxSteps(maxSteps_), _rows(rows_), _cols(cols_), _name(name_), _docking(docking_), _totalDirt(totalDirt_), _currentDirt(totalDirt_), _isValid(true)
+{
+	_houseFilename = filenameWithoutSuffix_ + ".house";
+	_houseFilenameWithoutSuffix = filenameWithoutSuffix_;
+
+	// only the row pointers are allocated
+	_house = new char*[_rows];
+	for (size_t i = 0; i < _rows; i++)
+	{
+		_house[i] = const_cast<char*>(cells_ + i * (_cols + 1)); // never written, ownRows() copies them first
+	}
+	_ownsRows = false;
+	_dockingDistanceData = dockingDistance_;
+}
+
+
 void House::loadFromFile(const char* path_)
 {
 	_isValid = true;
-	ifstream fin(path_);
+	MappedFile file(path_);
 
-	if (!fin.is_open() || !fin.good())
+	if (!file.isOpen())
 	{
 
 #ifdef _DEBUG_
@@ -41,15 +203,35 @@ void House::loadFromFile(const char* path_)
 	}
 
 	freeHouse();
-	
-	std::getline(fin, _name);
-	if (!GetUnsignedIntFromStream(fin, &_maxSteps, 2) || !GetUnsignedIntFromStream(fin, &_rows, 3) || !GetUnsignedIntFromStream(fin, &_cols, 4))
+
+	const char* position = file.data();
+	const char* end = position + file.size();
+	size_t length;
+	const char* line = nextLine(position, end, length);
+	_name.assign(line, length);
+
+	line = nextLine(position, end, length);
+	if (!GetUnsignedIntFromLine(string(line, length), &_maxSteps, 2))
+	{
+		return;
+	}
+	line = nextLine(position, end, length);
+	if (!GetUnsignedIntFromLine(string(line, length), &_rows, 3))
+	{
+		return;
+	}
+	line = nextLine(position, end, length);
+	if (!GetUnsignedIntFromLine(string(line, length), &_cols, 4))
 	{
-		fin.close();
 		return;
 	}
-	
-	fin.ignore();	//skip newline and go the begining of matrix
+
+	// skips a character, as the stream version's ignore() did - the first row loses its first character (it's a wall
+	// anyway), or an empty first row is skipped altogether
+	if (position < end)
+	{
+		++position;
+	}
 
 	_house = new char*[_rows];
 	for (size_t i = 0; i < _rows; i++)
@@ -58,48 +240,28 @@ void House::loadFromFile(const char* path_)
 		_house[i][_cols] = '\0';
 		memset(_house[i], House::EMPTY, _cols); // fill in all places with spaces
 
-		string houseRow;
-		std::getline(fin, houseRow);
-		memcpy(_house[i], houseRow.c_str(), std::min(houseRow.size(), _cols));
+		line = nextLine(position, end, length);
+		memcpy(_house[i], line, std::min(length, _cols));
 	}
 
-	fin.close();
-
 	this->validateHouse();
 }
 
-bool House::GetUnsignedIntFromStream(ifstream& fin_, size_t* argPointer_, unsigned int rowNumber_)
+bool House::GetUnsignedIntFromLine(const string& line_, size_t* argPointer_, unsigned int rowNumber_)
 {
-	string line;
-	bool validLine = true;
-	int num = 0;
-
-	std::getline(fin_, line);
-	try
-	{
-		num = stoi(line);
-	}
-	catch (std::invalid_argument e)
-	{
-		validLine = false;
-	}
-	catch (std::out_of_range e)
-	{
-		validLine = false;
-	}
-
-	if (num <= 0)
-	{
-		validLine = false;
-	}
+	// what stoi accepts, without its exceptions: leading spaces, a sign and digits, anything after them
+	char* parsedEnd;
+	errno = 0;
+	long num = strtol(line_.c_str(), &parsedEnd, 10);
+	bool validLine = (parsedEnd != line_.c_str()) && (errno != ERANGE) && (num > 0) && (num <= INT_MAX);
 
 	if (!validLine)
 	{
 #ifdef _DEBUG_
-		cout << "[ERROR] Invalid line " << rowNumber_ << " " << line << endl;
+		cout << "[ERROR] Invalid line " << rowNumber_ << " " << line_ << endl;
 #endif
 		_isValid = false;
-		_errorLine = _houseFilename + ": line number " + std::to_string(rowNumber_) + " in house file shall be a positive number, found: " + line;
+		_errorLine = _houseFilename + ": line number " + std::to_string(rowNumber_) + " in house file shall be a positive number, found: " + line_;
 		return false;
 	}
 
@@ -117,6 +279,8 @@ void House::setHouse(const House& other)
 	_docking = other._docking;
 	_totalDirt = other._totalDirt;
 	_currentDirt = other._currentDirt;
+	_dockingDistance.clear(); // a copy is simulated on, it doesn't need them
+	_dockingDistanceData = nullptr;
 
 	_houseFilename = other._houseFilename;
 	_houseFilenameWithoutSuffix = other._houseFilenameWithoutSuffix;
@@ -136,7 +300,7 @@ void House::freeHouse()
 {
 	if (_house != nullptr)
 	{
-		for (size_t i = 0; i < _rows; i++)
+		for (size_t i = 0; i < _rows && _ownsRows; i++)
 		{
 			delete[] _house[i];
 		}
@@ -144,6 +308,7 @@ void House::freeHouse()
 		delete[] _house;
 		_house = nullptr;
 	}
+	_ownsRows = true;
 }
 
 
@@ -154,12 +319,15 @@ House::House(House&& other) :	_maxSteps(other._maxSteps),
 								_docking(other._docking),
 								_totalDirt(other._totalDirt),
 								_currentDirt(other._totalDirt),
+								_dockingDistance(std::move(other._dockingDistance)),
+								_dockingDistanceData(other._dockingDistanceData),
 								_houseFilename(other._houseFilename),
 								_houseFilenameWithoutSuffix(other._houseFilenameWithoutSuffix),
 								_isValid(other._isValid),
 								_errorLine(other._errorLine)
 {
 	std::swap(_house, other._house);
+	std::swap(_ownsRows, other._ownsRows);
 }
 
 
@@ -177,11 +345,14 @@ House& House::operator=(House&& other)
 	_rows = other._rows;
 	_cols = other._cols;
 	std::swap(_house, other._house);
+	std::swap(_ownsRows, other._ownsRows);
 
 	_name = other._name;
 	_docking = other._docking;
 	_totalDirt = other._totalDirt;
 	_currentDirt = other._totalDirt;
+	_dockingDistance = std::move(other._dockingDistance);
+	_dockingDistanceData = other._dockingDistanceData;
 	_houseFilename = other._houseFilename;
 	_houseFilenameWithoutSuffix = other._houseFilenameWithoutSuffix;
 	_isValid = other._isValid;
@@ -207,10 +378,30 @@ char& House::operator[](const Point& p)
 		throw (int)House::ERR;
 	}
 
+	ownRows();
 	return _house[p.getY()][p.getX()];
 }
 
+void House::ownRows()
+{
+	if (_ownsRows) return;
+
+	// a house in a pack - its rows are copied out of the read only mapping before they're written
+	for (size_t i = 0; i < _rows; i++)
+	{
+		char* row = new char[_cols + 1];
+		std::memcpy(row, _house[i], _cols + 1);
+		_house[i] = row;
+	}
+	_ownsRows = true;
+}
+
 void House::print(ostream& out) const
+{
+	this->print(out, nullptr);
+}
+
+void House::print(ostream& out, const Point* robot) const
 {
 	out << endl;
 
@@ -236,7 +427,16 @@ void House::print(ostream& out) const
 
 	for (size_t row = 0; row < _rows; ++row)
 	{
-		out << _house[row] << " " << row << endl;
+		if (robot != nullptr && robot->getY() == (int)row)
+		{
+			string line(_house[row]);
+			line[robot->getX()] = 'R';
+			out << line << " " << row << endl;
+		}
+		else
+		{
+			out << _house[row] << " " << row << endl;
+		}
 	}
 	
 	//out << endl << "Docking station at: " << _docking << endl;
@@ -247,13 +447,7 @@ void House::print(const Point& robot, ostream& out) const
 {
 	if (this->isInside(robot))
 	{
-		char last = (*this)[robot];
-		
-		// Const hack - temporarily changing character in house matrix, then changing it back (so overall - no change!)
-		House& h = const_cast<House&>(*this);
-		h[robot] = 'R';
-		this->print(out);
-		h[robot] = last;
+		this->print(out, &robot);
 	}
 	else
 	{
@@ -315,34 +509,40 @@ void House::validateHouse()
 
 	_currentDirt = 0; // update current dirt count
 	_isValid = true; 
+	ownRows();
 	for (size_t i = 0; i < _rows; ++i)
 	{
-		for (size_t j = 0; j < _cols; ++j)
+		char* row = _house[i];
+		if (i == 0 || i == _rows - 1)
 		{
-			char& curr = _house[i][j];
-
-			if (i == 0 || i == _rows - 1 || j == 0 || j == _cols - 1)
+			// fix surronding wall if needed
+			for (size_t j = 0; j < _cols; ++j)
 			{
-				// fix surronding wall if needed
-				if (curr != House::WALL)
+				if (row[j] != House::WALL)
 				{
-					curr = House::WALL;
+					row[j] = House::WALL;
 					fixedWalls = true;
 				}
 			}
-			else if (curr == House::CLEAN)
-			{
-				curr = House::EMPTY; // convert '0' dirt chars into ' ' chars
-			}
-			else if (curr >= House::DUST1 && curr <= House::DUST9)
-			{
-				_currentDirt += curr - House::CLEAN; // update current dirt count
-			}
-			else if (curr == House::DOCKING)
-			{
-				dockingCount++;
-				_docking = Point(j,i);
-			}
+			continue;
+		}
+
+		if (row[0] != House::WALL || row[_cols - 1] != House::WALL)
+		{
+			row[0] = row[_cols - 1] = House::WALL;
+			fixedWalls = true;
+		}
+
+		RowScan scan;
+		if (_cols > 2)
+		{
+			scanRow(row, 1, _cols - 1, scan);
+		}
+		_currentDirt += scan.dirt;
+		if (scan.dockingCount > 0)
+		{
+			dockingCount += scan.dockingCount;
+			_docking = Point(scan.lastDocking, i);
 		}
 	}
 
@@ -374,6 +574,56 @@ void House::validateHouse()
 }
 
 
+void House::findDockingDistances()
+{
+	if (_dockingDistanceData != nullptr) return;
+
+	_dockingDistance.assign(_rows * _cols, -1);
+
+	vector<int> queue;
+	queue.reserve(_rows * _cols);
+	queue.push_back(_docking.getY() * _cols + _docking.getX());
+	_dockingDistance[queue.back()] = 0;
+
+	_dockingDistanceData = _dockingDistance.data();
+
+	const int neighbours[] = { 1, -1, (int)_cols, -(int)_cols };
+	for (size_t head = 0; head < queue.size(); ++head)
+	{
+		int cell = queue[head];
+		for (int neighbour : neighbours)
+		{
+			// the surrounding wall keeps the neighbours inside the house
+			int next = cell + neighbour;
+			if (_dockingDistance[next] < 0 && _house[next / _cols][next % _cols] != House::WALL)
+			{
+				_dockingDistance[next] = _dockingDistance[cell] + 1;
+				queue.push_back(next);
+			}
+		}
+	}
+}
+
+
+int House::getDirtOutOfReach(int maxDistance_) const
+{
+	int dirt = 0;
+	for (size_t i = 0; i < _rows; ++i)
+	{
+		for (size_t j = 0; j < _cols; ++j)
+		{
+			char curr = _house[i][j];
+			int distance = _dockingDistanceData[i * _cols + j];
+			if (curr >= House::DUST1 && curr <= House::DUST9 && (distance < 0 || distance > maxDistance_))
+			{
+				dirt += curr - House::CLEAN;
+			}
+		}
+	}
+	return dirt;
+}
+
+
 vector<string> House::getMontageTiles(const Point& robot_) const
 {
 	vector<string> tiles;
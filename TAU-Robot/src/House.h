@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <vector>
+#include <climits>
 
 #include "Point.h"
 
@@ -16,12 +17,15 @@ class House
 	size_t	_rows;
 	size_t	_cols;
 	char**	_house = nullptr;
+	bool	_ownsRows = true;	// false for a house in a pack - the rows are in its (read only) mapping till the first write
 
 	string	_name;
 	
 	Point	_docking;
 	int		_totalDirt;
 	int		_currentDirt;
+	vector<int>	_dockingDistance;	// rows x cols, steps from the docking station (-1 = wall / sealed off), only once asked for
+	const int*	_dockingDistanceData = nullptr;	// _dockingDistance's, or the pack's - nullptr till findDockingDistances()
 
 	string _houseFilename;
 	string _houseFilenameWithoutSuffix;
@@ -35,6 +39,12 @@ public:
 	enum { ERR = 0, FILE_ERR };
 
 	House(const char* path_ = NULL);
+	// a house in memory (generated / benchmarks) - the rows as they'd be in a file, validated the same way
+	House(const string& name_, size_t maxSteps_, const vector<string>& rows_);
+	// a house in a HousePack, validated when it was packed - its rows (cols_ + 1 chars each, '\0' ended) and docking
+	// distances stay in the pack, which has to outlive the house (copies of it are ordinary houses)
+	House(const string& name_, const string& filenameWithoutSuffix_, size_t maxSteps_, size_t rows_, size_t cols_, const char* cells_,
+		const int* dockingDistance_, const Point& docking_, int totalDirt_);
 	House(const House& other) { setHouse(other); }
 	House(House&& other);
 	virtual ~House() { freeHouse(); }
@@ -49,6 +59,16 @@ public:
 
 	vector<string> getMontageTiles(const Point& robot_) const;
 
+	// BFS from the docking station, for the queries below (-reachable_done, -early_abandon, packing) - an int per cell,
+	// so only houses that need it have it, and copies don't keep it. A no-op if it's there (a pack's house has it).
+	void findDockingDistances();
+	// rows x cols, nullptr till findDockingDistances()
+	const int* getDockingDistances() const { return _dockingDistanceData; }
+	// -1 if p can't be reached from the docking station
+	int getDistanceToDocking(const Point& p) const { return isInside(p) ? _dockingDistanceData[p.getY() * _cols + p.getX()] : -1; }
+	// dirt sealed off from the docking station, or more than maxDistance_ steps away from it
+	int getDirtOutOfReach(int maxDistance_ = INT_MAX) const;
+
 	
 	// getters
 	string getName() const { return _name; }
@@ -78,10 +98,12 @@ private:
 	void loadFromFile(const char* path_);
 
 	const char operator[](const Point& p) const;
-	char& operator[](const Point& p);
+	char& operator[](const Point& p);	// for writing - copies a pack's rows first
+	void ownRows();
+	void print(ostream& out, const Point* robot) const;
 	bool isInside(const Point& p) const { return (p.getX() < (int)_cols) && (p.getX() >= 0) && (p.getY() < (int)_rows) && (p.getY() >= 0); }
 	void validateHouse();
-	bool GetUnsignedIntFromStream(ifstream& fin_, size_t* argPointer_, unsigned int rowNumber_);
+	bool GetUnsignedIntFromLine(const string& line_, size_t* argPointer_, unsigned int rowNumber_);
 };
 
 
@@ -0,0 +1,261 @@
+#include "HouseGenerator.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <sstream>
+
+
+namespace
+{
+	const size_t MAX_SIDE = 100000;
+
+	bool parseNumber(const string& text_, size_t& result_)
+	{
+		if (text_.empty() || text_.find_first_not_of("0123456789") != string::npos || text_.size() > 18) return false;
+		result_ = (size_t)strtoull(text_.c_str(), nullptr, 10);
+		return true;
+	}
+
+	bool parsePercent(const string& text_, int& result_)
+	{
+		size_t value;
+		if (!parseNumber(text_, value) || value > 100) return false;
+		result_ = (int)value;
+		return true;
+	}
+
+	// the floor cells get dirt: dirtPercent_ of them, 1..maxDirt_ each
+	void addDirt(vector<string>& rows_, mt19937& random_, int dirtPercent_, int maxDirt_)
+	{
+		for (string& row : rows_)
+		{
+			for (char& cell : row)
+			{
+				if (cell == House::EMPTY && (int)(random_() % 100) < dirtPercent_)
+				{
+					cell = (char)(House::DUST1 + random_() % maxDirt_);
+				}
+			}
+		}
+	}
+
+	// clamped to the inside of the surrounding wall
+	void carve(vector<string>& rows_, size_t top_, size_t left_, size_t bottom_, size_t right_)
+	{
+		top_ = max(top_, (size_t)1);
+		left_ = max(left_, (size_t)1);
+		bottom_ = min(bottom_, rows_.size() - 1);
+		right_ = min(right_, rows_[0].size() - 1);
+		if (left_ >= right_) return;
+
+		for (size_t i = top_; i < bottom_; ++i)
+		{
+			fill(rows_[i].begin() + left_, rows_[i].begin() + right_, (char)House::EMPTY);
+		}
+	}
+}
+
+
+bool HouseGenerator::Spec::parse(const string& spec_, Spec& result_, string& error_)
+{
+	vector<string> fields;
+	stringstream in(spec_);
+	string field;
+	while (getline(in, field, ':'))
+	{
+		fields.push_back(field);
+	}
+
+	Spec spec;
+	size_t x = (fields.size() > 1) ? fields[1].find('x') : string::npos;
+	size_t seed;
+	if (fields.size() < 4 || x == string::npos || !parseNumber(fields[1].substr(0, x), spec.cols) || !parseNumber(fields[1].substr(x + 1), spec.rows)
+		|| !parseNumber(fields[2], spec.count) || !parseNumber(fields[3], seed))
+	{
+		error_ = "expected <kind>:<W>x<H>:<count>:<seed>[:<option>=<value>...]";
+		return false;
+	}
+	spec.kind = fields[0];
+	spec.seed = (unsigned)seed;
+
+	if (spec.kind != "rooms" && spec.kind != "scattered")
+	{
+		error_ = "unknown kind '" + spec.kind + "' (rooms / scattered)";
+		return false;
+	}
+	if (spec.cols < 3 || spec.rows < 3 || spec.cols > MAX_SIDE || spec.rows > MAX_SIDE)
+	{
+		error_ = "the size must be 3x3 to " + to_string(MAX_SIDE) + "x" + to_string(MAX_SIDE);
+		return false;
+	}
+	if (spec.count == 0)
+	{
+		error_ = "the count must be at least 1";
+		return false;
+	}
+
+	for (size_t i = 4; i < fields.size(); ++i)
+	{
+		size_t equals = fields[i].find('=');
+		string name = fields[i].substr(0, equals), value = (equals != string::npos) ? fields[i].substr(equals + 1) : "";
+		size_t maxDirt = (size_t)spec.maxDirt;
+		bool ok;
+		if (name == "room") ok = parseNumber(value, spec.roomSize) && spec.roomSize > 0;
+		else if (name == "corridor") ok = parseNumber(value, spec.corridorWidth) && spec.corridorWidth > 0;
+		else if (name == "loops") ok = parsePercent(value, spec.loopPercent);
+		else if (name == "walls") ok = parsePercent(value, spec.wallPercent);
+		else if (name == "dirt") ok = parsePercent(value, spec.dirtPercent);
+		else if (name == "max_dirt") ok = parseNumber(value, maxDirt) && maxDirt >= 1 && maxDirt <= 9;
+		else if (name == "max_steps") ok = parseNumber(value, spec.maxSteps) && spec.maxSteps > 0 && spec.maxSteps <= INT_MAX;
+		else ok = false;
+
+		if (!ok)
+		{
+			error_ = "bad option '" + fields[i] + "' (room=, corridor=, loops=, walls=, dirt=, max_dirt= 1-9, max_steps=)";
+			return false;
+		}
+		spec.maxDirt = (int)maxDirt;
+	}
+
+	if (spec.maxSteps == 0)
+	{
+		spec.maxSteps = min(2 * spec.rows * spec.cols, (size_t)INT_MAX);
+	}
+
+	result_ = spec;
+	return true;
+}
+
+
+vector<string> HouseGenerator::scattered(size_t rows_, size_t cols_, unsigned seed_, int wallPercent_, int dirtPercent_, int maxDirt_)
+{
+	// mt19937 itself is the same everywhere (the std distributions aren't)
+	mt19937 random(seed_);
+	vector<string> rows(rows_, string(cols_, House::EMPTY));
+
+	for (size_t i = 0; i < rows_; ++i)
+	{
+		for (size_t j = 0; j < cols_; ++j)
+		{
+			int roll = random() % 100;
+			if (i == 0 || j == 0 || i == rows_ - 1 || j == cols_ - 1 || roll < wallPercent_)
+			{
+				rows[i][j] = House::WALL;
+			}
+			else if (roll < wallPercent_ + dirtPercent_)
+			{
+				rows[i][j] = (char)(House::DUST1 + random() % maxDirt_);
+			}
+		}
+	}
+
+	if (rows_ > 2 && cols_ > 2)
+	{
+		rows[rows_ / 2][cols_ / 2] = House::DOCKING;
+	}
+
+	return rows;
+}
+
+
+vector<string> HouseGenerator::rooms(size_t rows_, size_t cols_, unsigned seed_, size_t roomSize_, size_t corridorWidth_, int loopPercent_, int dirtPercent_, int maxDirt_)
+{
+	mt19937 random(seed_);
+	vector<string> rows(rows_, string(cols_, House::WALL));
+	if (rows_ < 3 || cols_ < 3) return rows;
+
+	// the inside is split to tiles of a room and a wall line each, a room is at least half its tile
+	size_t innerRows = rows_ - 2, innerCols = cols_ - 2;
+	size_t tilesY = max(innerRows / (roomSize_ + 1), (size_t)1), tilesX = max(innerCols / (roomSize_ + 1), (size_t)1);
+	vector<size_t> centerY(tilesY * tilesX), centerX(tilesY * tilesX);
+
+	for (size_t ty = 0; ty < tilesY; ++ty)
+	{
+		for (size_t tx = 0; tx < tilesX; ++tx)
+		{
+			size_t top = 1 + ty * innerRows / tilesY, bottom = 1 + (ty + 1) * innerRows / tilesY;
+			size_t left = 1 + tx * innerCols / tilesX, right = 1 + (tx + 1) * innerCols / tilesX;
+			size_t height = max(bottom - top - 1, (size_t)1), width = max(right - left - 1, (size_t)1);
+
+			size_t roomHeight = max(height / 2, (size_t)1) + random() % (height - max(height / 2, (size_t)1) + 1);
+			size_t roomWidth = max(width / 2, (size_t)1) + random() % (width - max(width / 2, (size_t)1) + 1);
+			size_t roomTop = top + random() % (height - roomHeight + 1), roomLeft = left + random() % (width - roomWidth + 1);
+			carve(rows, roomTop, roomLeft, roomTop + roomHeight, roomLeft + roomWidth);
+
+			centerY[ty * tilesX + tx] = roomTop + roomHeight / 2;
+			centerX[ty * tilesX + tx] = roomLeft + roomWidth / 2;
+		}
+	}
+
+	// an L shaped corridor between the centers of two rooms
+	auto connect = [&](size_t from_, size_t to_) {
+		size_t y = centerY[from_], x1 = min(centerX[from_], centerX[to_]), x2 = max(centerX[from_], centerX[to_]);
+		carve(rows, y, x1, y + corridorWidth_, x2 + corridorWidth_);
+		size_t x = centerX[to_], y1 = min(centerY[from_], centerY[to_]), y2 = max(centerY[from_], centerY[to_]);
+		carve(rows, y1, x, y2 + corridorWidth_, x + corridorWidth_);
+	};
+
+	// a random spanning tree of the tiles (depth first), so every room can be reached
+	vector<bool> visited(tilesY * tilesX, false);
+	vector<size_t> stack(1, 0);
+	visited[0] = true;
+	while (!stack.empty())
+	{
+		size_t tile = stack.back(), ty = tile / tilesX, tx = tile % tilesX;
+		size_t neighbors[4];
+		size_t count = 0;
+		if (ty > 0 && !visited[tile - tilesX]) neighbors[count++] = tile - tilesX;
+		if (ty + 1 < tilesY && !visited[tile + tilesX]) neighbors[count++] = tile + tilesX;
+		if (tx > 0 && !visited[tile - 1]) neighbors[count++] = tile - 1;
+		if (tx + 1 < tilesX && !visited[tile + 1]) neighbors[count++] = tile + 1;
+
+		if (count == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
+		size_t next = neighbors[random() % count];
+		connect(tile, next);
+		visited[next] = true;
+		stack.push_back(next);
+	}
+
+	// and some loops
+	for (size_t tile = 0; tile < tilesY * tilesX; ++tile)
+	{
+		if ((int)(random() % 100) >= loopPercent_) continue;
+		if (random() % 2 == 0 && tile % tilesX + 1 < tilesX) connect(tile, tile + 1);
+		else if (tile + tilesX < tilesY * tilesX) connect(tile, tile + tilesX);
+	}
+
+	addDirt(rows, random, dirtPercent_, maxDirt_);
+
+	size_t docking = random() % (tilesY * tilesX);
+	rows[centerY[docking]][centerX[docking]] = House::DOCKING;
+	return rows;
+}
+
+
+House HouseGenerator::generate(const string& name_, size_t rows_, size_t cols_, unsigned seed_)
+{
+	return House(name_, 2 * rows_ * cols_, scattered(rows_, cols_, seed_));
+}
+
+
+House HouseGenerator::generate(const Spec& spec_, size_t index_)
+{
+	// seed_seq is specified by the standard - the same seeds everywhere
+	seed_seq sequence{ spec_.seed, (unsigned)index_, (unsigned)((uint64_t)index_ >> 32) };
+	unsigned seed;
+	sequence.generate(&seed, &seed + 1);
+
+	string index = to_string(index_);
+	size_t width = to_string(spec_.count - 1).size();
+	string name = spec_.kind + "-" + string(width - min(width, index.size()), '0') + index;
+
+	vector<string> rows = (spec_.kind == "scattered")
+		? scattered(spec_.rows, spec_.cols, seed, spec_.wallPercent, spec_.dirtPercent, spec_.maxDirt)
+		: rooms(spec_.rows, spec_.cols, seed, spec_.roomSize, spec_.corridorWidth, spec_.loopPercent, spec_.dirtPercent, spec_.maxDirt);
+	return House(name, spec_.maxSteps, rows);
+}
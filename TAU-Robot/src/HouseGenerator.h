@@ -0,0 +1,50 @@
+#ifndef __HOUSE_GENERATOR__H_
+#define __HOUSE_GENERATOR__H_
+
+#include <string>
+#include <vector>
+
+#include "House.h"
+
+using namespace std;
+
+
+// Synthetic houses of any size (benchmarks, scaling, -house_gen) - the same seed gives the same house on every platform
+class HouseGenerator
+{
+public:
+	// a corpus of houses: <kind>:<W>x<H>:<count>:<seed>[:<option>=<value>...] (e.g. rooms:200x100:10000:7:dirt=20)
+	struct Spec
+	{
+		string		kind;				// rooms / scattered
+		size_t		cols = 0;
+		size_t		rows = 0;
+		size_t		count = 0;
+		unsigned	seed = 0;
+		size_t		roomSize = 12;		// room=, rooms: the largest room side
+		size_t		corridorWidth = 1;	// corridor=
+		int			loopPercent = 10;	// loops=, rooms: extra corridors (in % of the rooms) besides the ones connecting them all
+		int			wallPercent = 10;	// walls=, scattered: inner cells that are walls
+		int			dirtPercent = 30;	// dirt=, floor cells with dirt
+		int			maxDirt = 9;		// max_dirt=, the dirt of a cell is 1..max_dirt
+		size_t		maxSteps = 0;		// max_steps=, 0 = 2 * W * H
+
+		// false with error_ if spec_ is malformed
+		static bool parse(const string& spec_, Spec& result_, string& error_);
+	};
+
+	// walls around, wallPercent_ of the inner cells are walls and dirtPercent_ are dirt (1-maxDirt_), docking in the middle
+	static vector<string> scattered(size_t rows_, size_t cols_, unsigned seed_, int wallPercent_ = 10, int dirtPercent_ = 30, int maxDirt_ = 9);
+
+	// walls around, rooms of up to roomSize_ on a side connected by corridors (all reachable), docking in one of the rooms
+	static vector<string> rooms(size_t rows_, size_t cols_, unsigned seed_, size_t roomSize_ = 12, size_t corridorWidth_ = 1, int loopPercent_ = 10,
+		int dirtPercent_ = 30, int maxDirt_ = 9);
+
+	static House generate(const string& name_, size_t rows_, size_t cols_, unsigned seed_);
+
+	// house index_ of the corpus - its own seed (from the spec's seed and index_), named <kind>-<index>
+	static House generate(const Spec& spec_, size_t index_);
+};
+
+
+#endif //__HOUSE_GENERATOR__H_
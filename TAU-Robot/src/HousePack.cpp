@@ -0,0 +1,200 @@
+#include "HousePack.h"
+
+#include <cstring>
+#include <fstream>
+
+
+const char HousePack::MAGIC[8] = { 'T', 'A', 'U', 'H', 'P', 'A', 'C', 'K' };
+
+
+namespace
+{
+	const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	struct PackHeader
+	{
+		char		magic[8];
+		uint32_t	version;
+		uint32_t	byteOrder;
+		uint64_t	count;
+		uint64_t	indexOffset;
+	};
+
+	// the names follow it ('\0' ended), the offsets are from the record's start
+	struct PackedHouse
+	{
+		uint64_t	maxSteps;
+		uint32_t	rows;
+		uint32_t	cols;
+		int32_t		dockingX;
+		int32_t		dockingY;
+		int32_t		totalDirt;
+		uint32_t	nameLength;
+		uint32_t	filenameLength;
+		uint32_t	reserved;
+		uint64_t	cellsOffset;
+		uint64_t	distancesOffset;
+	};
+
+	uint64_t align(uint64_t offset_) { return (offset_ + 7) & ~(uint64_t)7; }
+
+	// writes and counts, padding to 8 bytes on request
+	class PackWriter
+	{
+		ofstream	_out;
+		uint64_t	_offset = 0;
+
+	public:
+		explicit PackWriter(const string& path_) : _out(path_, ios::binary | ios::trunc) {}
+
+		bool good() const { return _out.good(); }
+		uint64_t offset() const { return _offset; }
+		void write(const void* data_, size_t size_) { _out.write((const char*)data_, size_); _offset += size_; }
+		void pad() { static const char zeros[8] = {}; write(zeros, align(_offset) - _offset); }
+		void rewriteHeader(const PackHeader& header_) { _out.seekp(0); _out.write((const char*)&header_, sizeof(header_)); }
+	};
+}
+
+
+HousePack::HousePack(const char* path_) : _file(path_)
+{
+	if (!_file.isOpen())
+	{
+		_error = "cannot open file";
+		return;
+	}
+
+	const PackHeader* header = (const PackHeader*)_file.data();
+	if (_file.size() < sizeof(PackHeader) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		_error = "not a house pack";
+	}
+	else if (header->byteOrder != BYTE_ORDER_MARK)
+	{
+		_error = "written on a machine of a different byte order";
+	}
+	else if (header->version != VERSION)
+	{
+		_error = "version " + to_string(header->version) + " (this simulator reads version " + to_string(VERSION) + ")";
+	}
+	else if (header->indexOffset % 8 != 0 || header->indexOffset > _file.size() || header->count > (_file.size() - header->indexOffset) / sizeof(uint64_t))
+	{
+		_error = "damaged index";
+	}
+	else
+	{
+		_count = header->count;
+		_index = (const uint64_t*)(_file.data() + header->indexOffset);
+	}
+}
+
+
+House* HousePack::createHouse(size_t index_) const
+{
+	if (!isValid() || index_ >= _count) return nullptr;
+
+	uint64_t offset = _index[index_];
+	size_t size = _file.size();
+	if (offset % 8 != 0 || offset > size || size - offset < sizeof(PackedHouse)) return nullptr;
+
+	const char* record = _file.data() + offset;
+	const PackedHouse* house = (const PackedHouse*)record;
+	uint64_t cells = (uint64_t)house->rows * house->cols;
+	uint64_t available = size - offset;
+	if (house->rows == 0 || house->cols == 0 || house->maxSteps == 0
+		|| sizeof(PackedHouse) + (uint64_t)house->nameLength + house->filenameLength + 2 > available
+		|| house->cellsOffset > available || (available - house->cellsOffset) < cells + house->rows
+		|| house->distancesOffset % 4 != 0 || house->distancesOffset > available || (available - house->distancesOffset) / sizeof(int32_t) < cells
+		|| house->dockingX < 0 || house->dockingY < 0 || (uint32_t)house->dockingX >= house->cols || (uint32_t)house->dockingY >= house->rows)
+	{
+		return nullptr;
+	}
+
+	const char* names = record + sizeof(PackedHouse);
+	string name(names, house->nameLength);
+	string filename(names + house->nameLength + 1, house->filenameLength);
+
+	return new House(name, filename, (size_t)house->maxSteps, house->rows, house->cols, record + house->cellsOffset,
+		(const int*)(record + house->distancesOffset), Point(house->dockingX, house->dockingY), house->totalDirt);
+}
+
+
+bool HousePack::write(const vector<House*>& houses_, const string& path_, string& error_)
+{
+	PackWriter out(path_);
+	if (!out.good())
+	{
+		error_ = "cannot create " + path_;
+		return false;
+	}
+
+	PackHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.count = 0;
+	header.indexOffset = 0;
+	out.write(&header, sizeof(header));
+	out.pad();
+
+	vector<uint64_t> index;
+	string row;
+	vector<int32_t> distances;
+	for (House* house : houses_)
+	{
+		if (!house->isValid()) continue;
+		house->findDockingDistances();
+
+		string name = house->getName(), filename = house->getFilenameWithoutSuffix();
+		size_t rows = house->getYSize(), cols = house->getXSize();
+		uint64_t start = out.offset();
+
+		PackedHouse packed;
+		memset(&packed, 0, sizeof(packed));
+		packed.maxSteps = house->getMaxSteps();
+		packed.rows = (uint32_t)rows;
+		packed.cols = (uint32_t)cols;
+		packed.dockingX = house->getDocking().getX();
+		packed.dockingY = house->getDocking().getY();
+		packed.totalDirt = house->getTotalDirtAmount();
+		packed.nameLength = (uint32_t)name.size();
+		packed.filenameLength = (uint32_t)filename.size();
+		packed.cellsOffset = align(sizeof(PackedHouse) + name.size() + filename.size() + 2);
+		packed.distancesOffset = align(packed.cellsOffset + rows * (cols + 1));
+
+		out.write(&packed, sizeof(packed));
+		out.write(name.c_str(), name.size() + 1);
+		out.write(filename.c_str(), filename.size() + 1);
+		out.pad();
+
+		distances.resize(rows * cols);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			row.assign(cols + 1, '\0');
+			for (size_t j = 0; j < cols; ++j)
+			{
+				Point p((int)j, (int)i);
+				row[j] = house->at(p);
+				distances[i * cols + j] = house->getDistanceToDocking(p);
+			}
+			out.write(row.data(), row.size());
+		}
+		out.pad();
+		out.write(distances.data(), distances.size() * sizeof(int32_t));
+		out.pad();
+
+		index.push_back(start);
+	}
+
+	header.count = index.size();
+	header.indexOffset = out.offset();
+	out.write(index.data(), index.size() * sizeof(uint64_t));
+	out.rewriteHeader(header);
+
+	if (!out.good())
+	{
+		error_ = "cannot write " + path_;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+#ifndef __HOUSE_PACK__H_
+#define __HOUSE_PACK__H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "House.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+
+// A corpus of validated houses in one file (.hpack, -write_house_pack), read memory mapped (-house_path <pack>).
+// The houses made from it keep their rows and docking distances in the mapping - nothing is parsed, validated or
+// copied, and simulator processes reading the same pack share its pages.
+//
+// Layout (in the byte order of the machine that wrote it, checked on reading), every part 8 byte aligned:
+//   header:  magic, version, byte order mark, house count, offset of the index
+//   index:   the offset of each house's record
+//   record:  max steps, rows, cols, docking, total dirt, the name and the file name (without .house),
+//            the rows (cols + 1 chars each, '\0' ended), the docking distances (int32, rows x cols)
+class HousePack
+{
+	MappedFile		_file;
+	string			_error;
+	uint64_t		_count = 0;
+	const uint64_t*	_index = nullptr;
+
+public:
+	static const char		MAGIC[8];
+	static const uint32_t	VERSION = 1;
+
+	explicit HousePack(const char* path_);
+
+	HousePack(const HousePack&) = delete;
+	HousePack& operator=(const HousePack&) = delete;
+
+	bool isValid() const { return _error.empty(); }
+	string getError() const { return _error; }
+	size_t size() const { return (size_t)_count; }
+
+	// house index_, in the pack's order - nullptr if its record is damaged (the house needs the pack alive)
+	House* createHouse(size_t index_) const;
+
+	// the valid houses_ to path_ (with their docking distances, found on the way) - false with error_ if it can't be written
+	static bool write(const vector<House*>& houses_, const string& path_, string& error_);
+};
+
+
+#endif //__HOUSE_PACK__H_
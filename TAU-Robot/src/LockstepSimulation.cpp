@@ -0,0 +1,506 @@
+#include "LockstepSimulation.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+
+
+LockstepSimulation::LockstepSimulation(const Configuration& config_, const House& house_, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_,
+	const map<string, AllocationProfile>* setupProfiles_)
+{
+	_batteryCapacity = config_["BatteryCapacity"];
+	_batteryRechargeRate = config_["BatteryRechargeRate"];
+	_batteryConsumptionRate = config_["BatteryConsumptionRate"];
+	_cpuBudget = CpuBudget(config_);
+
+	_cols = house_.getXSize();
+	_rows = house_.getYSize();
+	_area = _cols * _rows;
+	_dockingX = house_.getDocking().getX();
+	_dockingY = house_.getDocking().getY();
+	_totalDirt = house_.getTotalDirtAmount();
+
+	size_t robots = algorithms_.size();
+	_planRunners.resize(robots);
+	_sensors.resize(robots);
+	_cells.resize(robots * _area);
+	_x.assign(robots, _dockingX);
+	_y.assign(robots, _dockingY);
+	_battery.assign(robots, _batteryCapacity);
+	_steps.assign(robots, 0);
+	_cleanedDirt.assign(robots, 0);
+	_dirtLeft.assign(robots, house_.getDirtAmount());
+	_prevStep.assign(robots, Direction::Stay);
+	_stuck.assign(robots, false);
+	_misbehavior.assign(robots, Misbehavior::None);
+	_cpuTime.assign(robots, 0);
+	_running.assign(robots, false);
+	_allocations.resize(robots);
+	_allocationProfiles.resize(robots);
+	if (StepClock::isEnabled())
+	{
+		_latency.resize(robots);
+	}
+	_perf.resize(robots);
+	_x1.assign(robots, -1);
+	_y1.assign(robots, -1);
+	_battery1.assign(robots, -1);
+	_x2.assign(robots, -1);
+	_y2.assign(robots, -1);
+	_battery2.assign(robots, -1);
+	_idleSteps.assign(robots, 0);
+	_parked.assign(robots, false);
+	_abandoned.assign(robots, false);
+	_lostStep.assign(robots, 0);
+	_stuckStep.assign(robots, 0);
+	_nextLostCheck.assign(robots, 0);
+	_dockingDistance = house_.getDockingDistances();
+
+	for (int y = 0; y < _rows; ++y)
+	{
+		for (int x = 0; x < _cols; ++x)
+		{
+			_cells[y * _cols + x] = house_.at(Point(x, y));
+		}
+	}
+
+	int robot = 0;
+	for (auto it = algorithms_.begin(); it != algorithms_.end(); ++it, ++robot)
+	{
+		if (robot > 0)
+		{
+			std::copy(_cells.begin(), _cells.begin() + _area, _cells.begin() + robot * _area);
+		}
+
+		_algoNames.push_back(it->first);
+		_algos.push_back(it->second.release());
+		_active.push_back(robot);
+
+		updateSensor(robot);
+
+		if (setupProfiles_ != nullptr && setupProfiles_->count(it->first) > 0)
+		{
+			_allocationProfiles[robot].continueFrom(setupProfiles_->at(it->first));
+		}
+
+		AllocationCounter::Scope allocations(allocationProfile(robot));
+		_algos[robot]->setConfiguration(config_.getParams());
+		_algos[robot]->setSensor(_sensors[robot]);
+		_planRunners[robot].attach(_algos[robot]);
+	}
+}
+
+
+LockstepSimulation::~LockstepSimulation()
+{
+	for (AbstractAlgorithm* algo : _algos)
+	{
+		delete algo;
+	}
+}
+
+
+char LockstepSimulation::cellAt(int robot, int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= _cols || y >= _rows)
+	{
+		return House::ERR;
+	}
+	return _cells[robot * _area + y * _cols + x];
+}
+
+
+void LockstepSimulation::updateSensor(int robot)
+{
+	SensorInformation& info = _sensors[robot]._info;
+
+	char state = cellAt(robot, _x[robot], _y[robot]);
+	info.dirtLevel = (state >= House::DUST1 && state <= House::DUST9) ? (int)(state - '0') : 0;
+
+	info.isWall[(int)Direction::East] = (cellAt(robot, _x[robot] + 1, _y[robot]) == House::WALL);
+	info.isWall[(int)Direction::West] = (cellAt(robot, _x[robot] - 1, _y[robot]) == House::WALL);
+	info.isWall[(int)Direction::South] = (cellAt(robot, _x[robot], _y[robot] + 1) == House::WALL);
+	info.isWall[(int)Direction::North] = (cellAt(robot, _x[robot], _y[robot] - 1) == House::WALL);
+}
+
+
+bool LockstepSimulation::step(vector<int>& misbehaved_)
+{
+	misbehaved_.clear();
+	_stepIndex++;
+	PerfSample phaseStart = PerfCounters::isEnabled() ? PerfCounters::read() : PerfSample();
+
+	// battery - a robot with an empty battery is stuck (unless it's in docking with exactly 0),
+	// the others are charged if they start from docking (even if they leave) or pay for the step
+	for (int robot : _active)
+	{
+		if (_parked[robot])
+		{
+			replayIdleStep(robot);
+			_running[robot] = false;
+			continue;
+		}
+
+		bool inDocking = (_x[robot] == _dockingX && _y[robot] == _dockingY);
+		int& battery = _battery[robot];
+
+		if (battery < 0 || (battery == 0 && !inDocking))
+		{
+			_stuck[robot] = true;
+			_running[robot] = false;
+			continue;
+		}
+
+		_running[robot] = true;
+		battery = inDocking ? std::min(_batteryCapacity, battery + _batteryRechargeRate) : battery - _batteryConsumptionRate;
+	}
+
+	// the algorithms' moves - the robots don't share anything, so they can be asked in parallel
+	_moving.clear();
+	for (int robot : _active)
+	{
+		if (_running[robot])
+		{
+			_moving.push_back(robot);
+		}
+	}
+
+	if (PerfCounters::isEnabled())
+	{
+		_simulatorPerf += PerfCounters::read() - phaseStart;
+	}
+
+	bool countAllocations = AllocationCounter::isEnabled();
+	if (_stepper != nullptr)
+	{
+		auto job = [this, countAllocations](size_t i) { moveRobot(_moving[i], countAllocations); };
+		_stepper->run(_moving.size(), job);
+	}
+	else
+	{
+		for (int robot : _moving)
+		{
+			moveRobot(robot, countAllocations);
+		}
+	}
+
+	if (PerfCounters::isEnabled())
+	{
+		phaseStart = PerfCounters::read();
+	}
+
+	// moving - walls and outside the house, cleaning
+	for (int robot : _active)
+	{
+		if (!_running[robot]) continue;
+
+		// too slow - stopped before its move
+		if (_misbehavior[robot] != Misbehavior::None)
+		{
+			_running[robot] = false;
+			continue;
+		}
+
+		Point location(_x[robot], _y[robot]);
+		location.move(_prevStep[robot]);
+		_x[robot] = location.getX();
+		_y[robot] = location.getY();
+		_steps[robot]++;
+
+		char cell = cellAt(robot, _x[robot], _y[robot]);
+		if (cell == House::ERR || cell == House::WALL)
+		{
+			_misbehavior[robot] = Misbehavior::Wall;
+			_running[robot] = false;
+			continue;
+		}
+
+		bool cleaned = (cell >= House::DUST1 && cell <= House::DUST9);
+		if (cleaned)
+		{
+			char& dirt = _cells[robot * _area + _y[robot] * _cols + _x[robot]];
+			dirt = (dirt == House::DUST1) ? (char)House::EMPTY : dirt - 1;
+			_cleanedDirt[robot]++;
+			_dirtLeft[robot]--;
+		}
+
+		updateSensor(robot);
+
+		if (_idleWindow > 0)
+		{
+			trackIdle(robot, cleaned);
+		}
+
+		if (_earlyAbandon && _nextLostCheck[robot] <= _stepIndex && isLost(robot))
+		{
+			_abandoned[robot] = true;
+		}
+	}
+
+	// stopped and done robots leave the active set, abandoned ones go to _lost
+	bool someoneDone = false;
+	size_t stoppedBefore = _stopped.size();
+	settleLost();
+	for (size_t i = 0; i < _active.size(); )
+	{
+		int robot = _active[i];
+		bool done = isDone(robot);
+		someoneDone = someoneDone || done;
+
+		if (_abandoned[robot])
+		{
+			_lost.push_back(robot);
+			_active[i] = _active.back();
+			_active.pop_back();
+		}
+		else if ((!_running[robot] && !_parked[robot]) || done)
+		{
+			if (_misbehavior[robot] != Misbehavior::None)
+			{
+				misbehaved_.push_back(robot);
+			}
+			else
+			{
+				_stopped.push_back(robot);
+			}
+			_active[i] = _active.back();
+			_active.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// same order as stepping the robots one after the other
+	std::sort(misbehaved_.begin(), misbehaved_.end());
+	std::sort(_stopped.begin() + stoppedBefore, _stopped.end());
+
+	if (PerfCounters::isEnabled())
+	{
+		_simulatorPerf += PerfCounters::read() - phaseStart;
+	}
+
+	return someoneDone;
+}
+
+
+void LockstepSimulation::moveRobot(int robot, bool countAllocations)
+{
+	size_t allocationsBefore = countAllocations ? AllocationCounter::count() : 0;
+	uint64_t stepStart = StepClock::isEnabled() ? StepClock::now() : 0;
+	uint64_t cpuStart = _cpuBudget.isSet() ? StepClock::threadCpuTime() : 0;
+	PerfSample perfStart = PerfCounters::isEnabled() ? PerfCounters::read() : PerfSample();
+	{
+		AllocationCounter::Scope allocations(allocationProfile(robot));
+		_prevStep[robot] = _planRunners[robot].nextMove(*_algos[robot], _prevStep[robot], _sensors[robot]._info, _battery[robot]);
+	}
+	if (PerfCounters::isEnabled())
+	{
+		_perf[robot] += PerfCounters::read() - perfStart;
+	}
+	if (StepClock::isEnabled())
+	{
+		_latency[robot].add(StepClock::toNanoseconds(StepClock::now() - stepStart));
+	}
+
+	if (_cpuBudget.isSet())
+	{
+		uint64_t stepTime = StepClock::threadCpuTime() - cpuStart;
+		_cpuTime[robot] += stepTime;
+		_misbehavior[robot] = _cpuBudget.check(stepTime, _cpuTime[robot]);
+	}
+	if (countAllocations)
+	{
+		_allocations[robot].addStep(AllocationCounter::count() - allocationsBefore);
+	}
+}
+
+
+bool LockstepSimulation::isLost(int robot)
+{
+	// the moves left before the battery runs out (it's never charged again)
+	int battery = _battery[robot];
+	int movesLeft = (battery <= 0) ? 0 : (_batteryConsumptionRate > 0) ? (battery + _batteryConsumptionRate - 1) / _batteryConsumptionRate : INT_MAX;
+
+	int distance = _dockingDistance[_y[robot] * _cols + _x[robot]];
+	if (distance <= movesLeft) return false;
+
+	// no dirt it can get to - the distance to p is at least the manhattan distance (so only the box of movesLeft around
+	// the robot is looked at), and at least the difference in the distances to docking
+	int x0 = std::max(0, _x[robot] - movesLeft), x1 = std::min(_cols - 1, _x[robot] + movesLeft);
+	int y0 = std::max(0, _y[robot] - movesLeft), y1 = std::min(_rows - 1, _y[robot] + movesLeft);
+	const char* cells = &_cells[robot * _area];
+	for (int y = y0; y <= y1; ++y)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			int i = y * _cols + x;
+			if (cells[i] >= House::DUST1 && cells[i] <= House::DUST9 && _dockingDistance[i] >= 0)
+			{
+				int bound = std::max(std::abs(x - _x[robot]) + std::abs(y - _y[robot]), std::abs(_dockingDistance[i] - distance));
+				if (bound <= movesLeft)
+				{
+					// a step adds at most 1 to the bound and takes 1 from movesLeft - the dirt stays in reach till then
+					_nextLostCheck[robot] = _stepIndex + (movesLeft - bound) / 2 + 1;
+					return false;
+				}
+			}
+		}
+	}
+
+	// it makes its last moves and is stuck by the battery check right after them
+	_lostStep[robot] = _stepIndex;
+	_stuckStep[robot] = _stepIndex + movesLeft + 1;
+	return true;
+}
+
+
+void LockstepSimulation::settleLost()
+{
+	// the abandoned robots stuck by now, in the order a full run stops them (by step, then by id)
+	std::sort(_lost.begin(), _lost.end(), [this](int a, int b) { return (_stuckStep[a] != _stuckStep[b]) ? _stuckStep[a] < _stuckStep[b] : a < b; });
+
+	size_t settled = 0;
+	while (settled < _lost.size() && _stuckStep[_lost[settled]] <= _stepIndex)
+	{
+		int robot = _lost[settled++];
+		_stuck[robot] = true;
+		_stopped.push_back(robot);
+	}
+	_lost.erase(_lost.begin(), _lost.begin() + settled);
+}
+
+
+int LockstepSimulation::abandonedStepsOf(int robot) const
+{
+	// _steps stopped when it was abandoned - the steps made since, up to the one before it's stuck
+	return _abandoned[robot] ? std::min(_stepIndex, _stuckStep[robot] - 1) - _lostStep[robot] : 0;
+}
+
+
+size_t LockstepSimulation::getAbandonedSteps() const
+{
+	size_t steps = 0;
+	for (size_t robot = 0; robot < _algos.size(); ++robot)
+	{
+		steps += abandonedStepsOf(robot);
+	}
+	return steps;
+}
+
+
+int LockstepSimulation::stepsToLastStop() const
+{
+	if (!_active.empty() || _lost.empty()) return INT_MAX;
+
+	int lastStop = 0;
+	for (int robot : _lost)
+	{
+		lastStop = std::max(lastStop, _stuckStep[robot]);
+	}
+	return lastStop - _stepIndex;
+}
+
+
+void LockstepSimulation::trackIdle(int robot, bool cleaned)
+{
+	// a state equal to the one two steps ago covers both staying in place and bouncing between two cells
+	bool repeated = !cleaned && (_x[robot] == _x2[robot]) && (_y[robot] == _y2[robot]) && (_battery[robot] == _battery2[robot]);
+	_idleSteps[robot] = repeated ? _idleSteps[robot] + 1 : 0;
+
+	_x2[robot] = _x1[robot];
+	_y2[robot] = _y1[robot];
+	_battery2[robot] = _battery1[robot];
+	_x1[robot] = _x[robot];
+	_y1[robot] = _y[robot];
+	_battery1[robot] = _battery[robot];
+
+	if (_idleSteps[robot] >= _idleWindow)
+	{
+		_parked[robot] = true;
+		_parkedCount++;
+	}
+}
+
+
+void LockstepSimulation::replayIdleStep(int robot)
+{
+	// the next state of the loop is the one two steps ago (the one a step ago is the current one), the history rotates
+	std::swap(_x1[robot], _x2[robot]);
+	std::swap(_y1[robot], _y2[robot]);
+	std::swap(_battery1[robot], _battery2[robot]);
+	_x[robot] = _x1[robot];
+	_y[robot] = _y1[robot];
+	_battery[robot] = _battery1[robot];
+	_steps[robot]++;
+}
+
+
+void LockstepSimulation::skipSteps(int steps_)
+{
+	for (int robot : _active)
+	{
+		if (steps_ % 2 != 0)
+		{
+			replayIdleStep(robot);
+		}
+		_steps[robot] += steps_ - (steps_ % 2);
+	}
+
+	_stepIndex += steps_;
+	settleLost();
+}
+
+
+void LockstepSimulation::aboutToFinish(int stepsTillFinishing_)
+{
+	for (int robot : _active)
+	{
+		if (_parked[robot]) continue;
+		AllocationCounter::Scope allocations(allocationProfile(robot));
+		_planRunners[robot].aboutToFinish(*_algos[robot], stepsTillFinishing_);
+	}
+}
+
+
+SimulationResult LockstepSimulation::getResult(int robot) const
+{
+	SimulationResult result;
+	result.algoName = _algoNames[robot];
+	result.done = isDone(robot);
+	result.outOfBattery = _stuck[robot] != 0;
+	result.docked = (_x[robot] == _dockingX && _y[robot] == _dockingY);
+	result.steps = _steps[robot] + abandonedStepsOf(robot);
+	result.totalDirt = _totalDirt - _dirtLeftWhenDone;
+	result.cleanedDirt = _cleanedDirt[robot];
+	return result;
+}
+
+
+vector<SimulationResult> LockstepSimulation::getResults() const
+{
+	vector<int> active(_active);
+	active.insert(active.end(), _lost.begin(), _lost.end());
+	std::sort(active.begin(), active.end());
+
+	vector<SimulationResult> results;
+	for (int robot : active)
+	{
+		results.push_back(getResult(robot));
+	}
+	for (int robot : _stopped)
+	{
+		results.push_back(getResult(robot));
+	}
+	return results;
+}
+
+
+unique_ptr<AbstractAlgorithm> LockstepSimulation::releaseAlgorithm(int robot_)
+{
+	unique_ptr<AbstractAlgorithm> algo(_algos[robot_]);
+	_algos[robot_] = nullptr;
+	_planRunners[robot_].attach(nullptr);
+	return algo;
+}
@@ -0,0 +1,157 @@
+#ifndef __LOCKSTEP_SIMULATION__H_
+#define __LOCKSTEP_SIMULATION__H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "Direction.h"
+#include "AbstractAlgorithm.h"
+#include "House.h"
+#include "Sensor.h"
+#include "Configuration.h"
+#include "AllocationCounter.h"
+#include "StepLatency.h"
+#include "PlanRunner.h"
+#include "Simulation.h"
+#include "ParallelStepper.h"
+
+
+// All the simulations of one house (one robot per algorithm), stepped together.
+// Robot state is kept in arrays indexed by robot id (the algorithms' order), and every phase of a step
+// (battery, the algorithms' moves, walls / cleaning / done) is a loop over the active robots.
+// Same results as running a Simulation per algorithm, without montage / video support.
+class LockstepSimulation
+{
+	int		_batteryCapacity;
+	int		_batteryRechargeRate;
+	int		_batteryConsumptionRate;
+	CpuBudget	_cpuBudget;
+
+	int		_cols;
+	int		_rows;
+	int		_area;
+	int		_dockingX;
+	int		_dockingY;
+	int		_totalDirt;
+	int		_dirtLeftWhenDone = 0;	// dirt no robot can get to, the house counts as clean without it
+
+	// per robot
+	vector<string>				_algoNames;
+	vector<AbstractAlgorithm*>	_algos;
+	vector<PlanRunner>			_planRunners;
+	vector<Sensor>				_sensors;		// never reallocated, the algorithms keep pointers to them
+	vector<char>				_cells;			// robots x area, each robot cleans its own copy of the house
+	const int*					_dockingDistance = nullptr;	// the house's (area, -1 = wall / sealed off), only with early abandonment
+	vector<int>					_x;
+	vector<int>					_y;
+	vector<int>					_battery;
+	vector<int>					_steps;
+	vector<int>					_cleanedDirt;
+	vector<int>					_dirtLeft;
+	vector<Direction>			_prevStep;
+	vector<char>				_stuck;
+	vector<Misbehavior>			_misbehavior;
+	vector<uint64_t>			_cpuTime;		// in the algorithm's steps (ns), only measured with a CPU budget
+	vector<char>				_running;		// still running after this step's battery check / move
+	vector<AllocationStats>		_allocations;
+	vector<AllocationProfile>	_allocationProfiles;	// inside the algorithm's calls, only with -alloc_profile
+	vector<LatencyHistogram>	_latency;
+	vector<PerfSample>			_perf;			// in the algorithm's steps, only with -perf
+	PerfSample					_simulatorPerf;	// in the simulator's phases of the steps (battery, moving, cleaning)
+
+	// idle fast-forward (only with an idle window) - the robot state one and two steps ago, and for how many steps it repeated itself
+	vector<int>		_x1, _y1, _battery1;
+	vector<int>		_x2, _y2, _battery2;
+	vector<int>		_idleSteps;
+	vector<char>	_parked;		// idle robots - their algorithms aren't called any more, the 1 or 2 step loop is replayed instead
+	size_t			_parkedCount = 0;
+	int				_idleWindow = 0;	// 0 = no fast-forward
+
+	// early abandonment - robots that can't get back to docking and can't get to any more dirt leave _active for _lost,
+	// their last steps and the step their battery stops them on are known right away
+	bool			_earlyAbandon = false;
+	int				_stepIndex = 0;		// steps made (or skipped) so far
+	vector<char>	_abandoned;
+	vector<int>		_lost;				// robot ids abandoned and not stuck yet
+	vector<int>		_lostStep;			// per robot, the step it was abandoned on
+	vector<int>		_stuckStep;			// per robot, the step its battery check stops it on
+	vector<int>		_nextLostCheck;		// per robot, the first step isLost looks again (it had dirt in reach with moves to spare)
+
+	vector<int>		_active;	// robot ids still running (unordered, removed with swap-remove)
+	vector<int>		_stopped;	// robot ids that stopped without misbehaving, in the order they stopped
+	vector<int>		_moving;	// robot ids the algorithms are asked for a move on this step
+
+	ParallelStepper*	_stepper = nullptr;	// the algorithms' moves of a step run in parallel on it (if set)
+
+public:
+	// setupProfiles_ - the algorithms' setup (-alloc_profile), their profiles here go on after them
+	LockstepSimulation(const Configuration& config_, const House& house_, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_,
+		const map<string, AllocationProfile>* setupProfiles_ = nullptr);
+	~LockstepSimulation();
+
+	LockstepSimulation(const LockstepSimulation&) = delete;
+	LockstepSimulation& operator=(const LockstepSimulation&) = delete;
+
+	size_t size() const { return _algos.size(); }
+	size_t activeCount() const { return _active.size() + _lost.size(); }
+	void setStepper(ParallelStepper* stepper_) { _stepper = stepper_; }
+
+	// Opt-in: a robot that repeats the same 1 or 2 step loop (same positions and battery, no dirt cleaned) for idleWindow_ steps
+	// is assumed to stay in it, its algorithm isn't called any more (not even aboutToFinish).
+	// Exact only if the algorithm really stays in the loop, -fast_forward_verify checks it.
+	void setIdleWindow(int idleWindow_) { _idleWindow = idleWindow_; }
+	// Opt-in heuristic: a robot that is too far from docking for its battery, and has no dirt within its battery's reach,
+	// can't clean or dock any more - it's settled right away as taking its last steps and getting stuck, its algorithm isn't
+	// called any more (not even aboutToFinish). Wrong if the algorithm would have gone on a wall or over its CPU budget
+	// in those steps, -fast_forward_verify checks it against the full run. Needs the house's docking distances.
+	void setEarlyAbandon(bool earlyAbandon_) { _earlyAbandon = earlyAbandon_; }
+	size_t getAbandonedSteps() const;
+
+	void setDirtLeftWhenDone(int dirt_) { _dirtLeftWhenDone = dirt_; }
+	bool allParked() const { return (_parkedCount == _active.size()) && activeCount() > 0; }
+
+	// with only abandoned robots left, the steps till the last one is stuck (the run ends then) - INT_MAX otherwise
+	int stepsToLastStop() const;
+
+	// advances the parked robots by steps_, the abandoned ones get stuck on the way - only when all the active robots are
+	// parked (nothing can change any more)
+	void skipSteps(int steps_);
+
+	// one step of all active robots. Robots that stopped leave the active set, misbehaved_ gets the ones that went on a wall
+	// or used up their CPU budget (by id).
+	// returns true if a robot is done (clean house and back in docking)
+	bool step(vector<int>& misbehaved_);
+	void aboutToFinish(int stepsTillFinishing_);
+
+	string getAlgoName(int robot_) const { return _algoNames[robot_]; }
+	Misbehavior getMisbehavior(int robot_) const { return _misbehavior[robot_]; }
+	const AllocationStats& getAllocationStats(int robot_) const { return _allocations[robot_]; }
+	const AllocationProfile& getAllocationProfile(int robot_) const { return _allocationProfiles[robot_]; }
+	const LatencyHistogram& getLatency(int robot_) const { return _latency[robot_]; }
+	const PerfSample& getPerf(int robot_) const { return _perf[robot_]; }
+	const PerfSample& getSimulatorPerf() const { return _simulatorPerf; }
+
+	// results of the robots that didn't misbehave - still active ones first (by id), then the stopped ones in the order they stopped
+	vector<SimulationResult> getResults() const;
+	unique_ptr<AbstractAlgorithm> releaseAlgorithm(int robot_);
+
+private:
+	char cellAt(int robot, int x, int y) const;
+	void updateSensor(int robot);
+	bool isDone(int robot) const { return _dirtLeft[robot] <= _dirtLeftWhenDone && _x[robot] == _dockingX && _y[robot] == _dockingY; }
+	SimulationResult getResult(int robot) const;
+	void moveRobot(int robot, bool countAllocations);
+	AllocationProfile* allocationProfile(int robot) { return AllocationCounter::isProfiling() ? &_allocationProfiles[robot] : nullptr; }
+	void trackIdle(int robot, bool cleaned);
+	bool isLost(int robot);
+	void settleLost();
+	int abandonedStepsOf(int robot) const;
+	void replayIdleStep(int robot);
+};
+
+
+#endif //__LOCKSTEP_SIMULATION__H_
@@ -0,0 +1,76 @@
+#ifndef __MAPPED_FILE__H_
+#define __MAPPED_FILE__H_
+
+#include <cstddef>
+using namespace std;
+
+#ifndef _WINDOWS_
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#include <iterator>
+#include <vector>
+#endif
+
+
+// A file's contents, read only - memory mapped, no copy and no stream buffering.
+// A file that opens but can't be mapped (empty, not a regular file) has no contents, like a stream that reads nothing.
+class MappedFile
+{
+	const char*	_data = nullptr;
+	size_t		_size = 0;
+	bool		_isOpen = false;
+
+#ifndef _WINDOWS_
+	void*		_mapping = MAP_FAILED;
+
+public:
+	explicit MappedFile(const char* path_)
+	{
+		int fd = open(path_, O_RDONLY);
+		if (fd < 0) return;
+		_isOpen = true;
+
+		struct stat status;
+		if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+		{
+			_mapping = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (_mapping != MAP_FAILED)
+			{
+				_data = (const char*)_mapping;
+				_size = (size_t)status.st_size;
+			}
+		}
+		close(fd); // the mapping stays
+	}
+	~MappedFile() { if (_mapping != MAP_FAILED) munmap(_mapping, _size); }
+#else
+	// for Windows tests only - read to memory
+	vector<char>	_contents;
+
+public:
+	explicit MappedFile(const char* path_)
+	{
+		ifstream in(path_, ios::binary);
+		if (!in.is_open()) return;
+		_isOpen = true;
+		_contents.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+		_data = _contents.data();
+		_size = _contents.size();
+	}
+	~MappedFile() {}
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return _isOpen; }
+	const char* data() const { return _data; }
+	size_t size() const { return _size; }
+};
+
+
+#endif //__MAPPED_FILE__H_
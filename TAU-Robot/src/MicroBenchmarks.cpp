@@ -0,0 +1,374 @@
+// Micro-benchmarks of the engine's hot functions (make bench) - on the shipped houses and on synthetic houses of growing
+// size, so the cost of a call can be compared across sizes (and across commits) as numbers.
+// usage: microbench [house dir...] [-score_formula <score_formula.so path>]
+
+#include <cstdio>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "House.h"
+#include "HouseGenerator.h"
+#include "Simulation.h"
+#include "Configuration.h"
+#include "OrderedAlgorithm.h"
+#include "SharedObjectLoader.h"
+#include "StringUtils.h"
+
+namespace fs = boost::filesystem;
+using namespace std;
+
+
+namespace
+{
+	const size_t SYNTHETIC_SIZES[] = { 16, 32, 64, 128, 256 };
+	const unsigned SYNTHETIC_SEED = 1;
+	const int EXPLORE_STEPS = 2000;	// at most, before the path searches
+	const chrono::milliseconds MIN_TIME(20);
+
+	volatile long sink; // results go here, so the calls aren't optimized away
+
+	// ns per operation - batch_() does some operations and returns how many, it's repeated for MIN_TIME at least
+	template <class Batch>
+	double timePerOperation(Batch batch_)
+	{
+		size_t operations = 0;
+		auto start = chrono::steady_clock::now();
+		chrono::steady_clock::duration elapsed;
+		do
+		{
+			operations += batch_();
+			elapsed = chrono::steady_clock::now() - start;
+		} while (elapsed < MIN_TIME);
+
+		return operations > 0 ? (double)chrono::duration_cast<chrono::nanoseconds>(elapsed).count() / operations : 0.0;
+	}
+
+	void report(const char* benchmark_, const House& house_, double nanoseconds_)
+	{
+		string size = to_string(house_.getYSize()) + "x" + to_string(house_.getXSize());
+		printf("%-34s %-14s %9s %14.1f\n", benchmark_, house_.getFilenameWithoutSuffix().c_str(), size.c_str(), nanoseconds_);
+	}
+
+
+	// the first open direction, starting one turn after the last one - enough to walk a house
+	class TrivialAlgorithm : public AbstractAlgorithm
+	{
+		const AbstractSensor*	_sensor = nullptr;
+		int						_next = 0;
+
+	public:
+		void setSensor(const AbstractSensor& sensor_) { _sensor = &sensor_; }
+		void setConfiguration(map<string, int> config_) {}
+		void aboutToFinish(int stepsTillFinishing_) {}
+
+		Direction step(Direction prevStep_)
+		{
+			SensorInformation info = _sensor->sense();
+			for (int i = 0; i < 4; ++i)
+			{
+				int direction = (_next + i) % 4;
+				if (!info.isWall[direction])
+				{
+					_next = (direction + 1) % 4;
+					return (Direction)direction;
+				}
+			}
+			return Direction::Stay;
+		}
+	};
+
+
+	// the shipped algorithms' base with its internals callable
+	class ExposedAlgorithm : public OrderedAlgorithm<Direction::East, Direction::West, Direction::South, Direction::North>
+	{
+	public:
+		using AlgorithmBase::dijakstra;
+		using AlgorithmBase::dijakstraHome;
+		using AlgorithmBase::findClosestPoint;
+		using AlgorithmBase::expandMatrix;
+
+		Point docking() const { return _docking; }
+		const set<Point>& targets() const { return _dirtyLocations.empty() ? _NLocations : _dirtyLocations; }
+		int houseLength() const { return _houseLength; }
+		int houseHeight() const { return _houseHeight; }
+		void moveTo(const Point& location_) { _robot.location = location_; }
+	};
+
+
+	Configuration makeConfiguration()
+	{
+		Configuration config;
+		config["MaxStepsAfterWinner"] = 200;
+		config["BatteryCapacity"] = 400;
+		config["BatteryConsumptionRate"] = 1;
+		config["BatteryRechargeRate"] = 20;
+		return config;
+	}
+
+
+	bool writeHouseFile(const House& house_, const vector<string>& rows_, const string& path_)
+	{
+		ofstream out(path_);
+		out << house_.getName() << endl << house_.getMaxSteps() << endl << rows_.size() << endl << (rows_.empty() ? 0 : rows_[0].size()) << endl;
+		for (const string& row : rows_)
+		{
+			out << row << endl;
+		}
+		return out.good();
+	}
+
+
+	// how far a simulation gets in (at most) steps_ steps
+	int run(Simulation& simulation_, int steps_)
+	{
+		int steps = 0;
+		while (steps < steps_ && simulation_.step() && !simulation_.isDone())
+		{
+			++steps;
+		}
+		return steps;
+	}
+
+
+	void benchmarkHouse(const House& house_, const Configuration& config_)
+	{
+		report("House::at (per cell)", house_, timePerOperation([&house_]() {
+			long sum = 0;
+			for (size_t y = 0; y < house_.getYSize(); ++y)
+			{
+				for (size_t x = 0; x < house_.getXSize(); ++x)
+				{
+					sum += house_.at(Point(x, y));
+				}
+			}
+			sink = sum;
+			return house_.getXSize() * house_.getYSize();
+		}));
+
+		House cleaned(house_);
+		report("House::clean (per cell)", house_, timePerOperation([&cleaned]() {
+			long sum = 0;
+			for (size_t y = 0; y < cleaned.getYSize(); ++y)
+			{
+				for (size_t x = 0; x < cleaned.getXSize(); ++x)
+				{
+					Point p(x, y);
+					sum += cleaned.clean(p);
+				}
+			}
+			sink = sum;
+			return cleaned.getXSize() * cleaned.getYSize();
+		}));
+
+		// a battery that doesn't run out - the trivial algorithm never goes back to docking
+		Configuration endless(config_);
+		endless["BatteryCapacity"] = INT_MAX / 2;
+		unique_ptr<AbstractAlgorithm> trivial(new TrivialAlgorithm());
+		Simulation walking(endless, house_, trivial, "trivial");
+		report("Simulation::step (trivial algo)", house_, timePerOperation([&walking]() {
+			return (size_t)max(run(walking, 1000), 1);
+		}));
+
+		trivial.reset(new TrivialAlgorithm());
+		Simulation sensed(config_, house_, trivial, "trivial");
+		report("Simulation::updateSensor", house_, timePerOperation([&sensed]() {
+			for (int i = 0; i < 1000; ++i)
+			{
+				sensed.updateSensor();
+			}
+			return (size_t)1000;
+		}));
+
+		// the algorithm half way through the house - a known map to search in, away from the docking station
+		ExposedAlgorithm* algorithm = new ExposedAlgorithm();
+		unique_ptr<AbstractAlgorithm> owned(algorithm);
+		Simulation explored(config_, house_, owned, "exposed");
+		run(explored, min((int)house_.getMaxSteps() / 2, EXPLORE_STEPS));
+
+		vector<Direction> path;
+		report("AlgorithmBase::dijakstra", house_, timePerOperation([algorithm, &path]() {
+			path.clear();
+			algorithm->dijakstra(algorithm->docking(), path);
+			return (size_t)1;
+		}));
+		report("AlgorithmBase::dijakstraHome", house_, timePerOperation([algorithm, &path]() {
+			path.clear();
+			algorithm->dijakstraHome(algorithm->docking(), path);
+			return (size_t)1;
+		}));
+		if (!algorithm->targets().empty())
+		{
+			report("AlgorithmBase::findClosestPoint", house_, timePerOperation([algorithm]() {
+				sink = algorithm->findClosestPoint(algorithm->targets()).getX();
+				return (size_t)1;
+			}));
+		}
+	}
+
+
+	void benchmarkExpandMatrix(const Configuration& config_)
+	{
+		// from the initial map (MAXHOUSELENGTH square), doubled expansions_ times towards the East
+		for (int expansions = 1; expansions <= 3; ++expansions)
+		{
+			ExposedAlgorithm algorithm;
+			algorithm.setConfiguration(config_.getParams());
+			double nanoseconds = timePerOperation([&algorithm, expansions]() {
+				algorithm.reset();
+				for (int i = 0; i < expansions; ++i)
+				{
+					algorithm.moveTo(Point(algorithm.houseLength() - 2, algorithm.houseHeight() / 2));
+					algorithm.expandMatrix();
+				}
+				return (size_t)1;
+			});
+
+			string size = to_string(MAXHOUSELENGTH) + "->" + to_string(MAXHOUSELENGTH << expansions);
+			printf("%-34s %-14s %9s %14.1f\n", "AlgorithmBase::reset+expandMatrix", "-", size.c_str(), nanoseconds);
+		}
+	}
+
+
+	map<string, int> scoreParams(int position_)
+	{
+		map<string, int> params;
+		params["actual_position_in_competition"] = position_;
+		params["simulation_steps"] = 1200;
+		params["winner_num_steps"] = 800;
+		params["this_num_steps"] = 1000;
+		params["sum_dirt_in_house"] = 120;
+		params["dirt_collected"] = 100;
+		params["is_back_in_docking"] = 1;
+		return params;
+	}
+
+
+	// the score formula the way Simulator::score calls it - the params map per result and the call
+	template <class ScoreFunction>
+	double timeScore(ScoreFunction score_)
+	{
+		return timePerOperation([&score_]() {
+			long sum = 0;
+			for (int position = 1; position <= 4; ++position)
+			{
+				sum += score_(scoreParams(position));
+			}
+			sink = sum;
+			return (size_t)4;
+		});
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	vector<string> houseDirs;
+	string scorePath = "./score_formula.so";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-score_formula") == 0 && i + 1 < argc)
+		{
+			scorePath = argv[++i];
+		}
+		else
+		{
+			houseDirs.push_back(argv[i]);
+		}
+	}
+
+	Configuration config = makeConfiguration();
+	vector<House> houses;
+	vector<string> housePaths;
+
+	for (const string& dir : houseDirs)
+	{
+		if (!fs::is_directory(dir)) continue;
+		vector<string> files;
+		for (fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it)
+		{
+			if (fs::is_regular_file(it->path()) && StringUtils::endsWith(it->path().generic_string(), ".house"))
+			{
+				files.push_back(it->path().generic_string());
+			}
+		}
+		sort(files.begin(), files.end());
+
+		for (const string& file : files)
+		{
+			House house(file.c_str());
+			if (house.isValid())
+			{
+				housePaths.push_back(file);
+				houses.push_back(std::move(house));
+			}
+		}
+	}
+
+	// synthetic houses, also written to files for the loading benchmark
+	fs::path tempDir = fs::temp_directory_path() / fs::unique_path("microbench-%%%%%%%%");
+	fs::create_directories(tempDir);
+	vector<vector<string>> syntheticRows;
+	for (size_t size : SYNTHETIC_SIZES)
+	{
+		string name = "synthetic" + to_string(size);
+		syntheticRows.push_back(HouseGenerator::scattered(size, size, SYNTHETIC_SEED));
+		houses.push_back(House(name, 2 * size * size, syntheticRows.back()));
+
+		string path = (tempDir / (name + ".house")).generic_string();
+		writeHouseFile(houses.back(), syntheticRows.back(), path);
+		housePaths.push_back(path);
+	}
+
+	printf("%-34s %-14s %9s %14s\n", "benchmark", "house", "size", "ns / op");
+
+	for (size_t i = 0; i < houses.size(); ++i)
+	{
+		const string& path = housePaths[i];
+		report("House load (file + validate)", houses[i], timePerOperation([&path]() {
+			House house(path.c_str());
+			sink = house.getDirtAmount();
+			return (size_t)1;
+		}));
+	}
+
+	for (size_t i = 0; i < syntheticRows.size(); ++i)
+	{
+		const House& house = houses[houses.size() - syntheticRows.size() + i];
+		const vector<string>& rows = syntheticRows[i];
+		report("House (rows) + validate", house, timePerOperation([&rows]() {
+			House generated("generated", 1, rows);
+			sink = generated.getDirtAmount();
+			return (size_t)1;
+		}));
+	}
+
+	for (const House& house : houses)
+	{
+		benchmarkHouse(house, config);
+	}
+
+	benchmarkExpandMatrix(config);
+
+	printf("%-34s %-14s %9s %14.1f\n", "score (built-in)", "-", "-", timeScore(Simulation::calc_score));
+	SharedObjectLoader scoreSO(scorePath.c_str());
+	typedef int(*score_func)(const map<string, int>&);
+	score_func scoreFunc = reinterpret_cast<score_func>(reinterpret_cast<long>(scoreSO.getFunctionPointer("calc_score")));
+	if (scoreFunc != NULL)
+	{
+		printf("%-34s %-14s %9s %14.1f\n", "score (score_formula.so)", "-", "-", timeScore(scoreFunc));
+	}
+	else
+	{
+		printf("%-34s cannot load %s\n", "score (score_formula.so)", scorePath.c_str());
+	}
+
+	fs::remove_all(tempDir);
+	return 0;
+}
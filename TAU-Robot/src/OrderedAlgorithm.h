@@ -0,0 +1,47 @@
+#ifndef __ORDERED_ALGORITHM__H_
+#define __ORDERED_ALGORITHM__H_
+
+#include "Direction.h"
+#include "AlgorithmBase.h"
+#include "Configuration.h"
+
+
+// AlgorithmBase with a compile time direction order (the order possible moves are tried in).
+// A new variant is a single typedef, e.g. typedef OrderedAlgorithm<Direction::East, Direction::West, Direction::South, Direction::North> _MyAlgo;
+template <Direction D1, Direction D2, Direction D3, Direction D4>
+class OrderedAlgorithm : public AlgorithmBase
+{
+	static constexpr Direction _order[4] = { D1, D2, D3, D4 };
+
+public:
+	OrderedAlgorithm() {}
+	OrderedAlgorithm(const AbstractSensor& sensor, const Configuration& conf) : AlgorithmBase(sensor, conf) {}
+
+	Direction step(Direction prevStep_)
+	{
+		// AfterMove because we can't be sure it moved (in cases of undisciplined robot)
+		updateAfterMove(prevStep_);
+
+		SensorInformation info = _sensor->sense(); // info.isWall = { East, West, South, North }
+
+		// unrolled over the order, each index is a compile time constant
+		MoveList possibleMoves;
+		if (!info.isWall[(int)_order[0]]) possibleMoves.push_back(_order[0]);
+		if (!info.isWall[(int)_order[1]]) possibleMoves.push_back(_order[1]);
+		if (!info.isWall[(int)_order[2]]) possibleMoves.push_back(_order[2]);
+		if (!info.isWall[(int)_order[3]]) possibleMoves.push_back(_order[3]);
+
+		Direction next = getMove(prevStep_, info, possibleMoves);
+
+		// BeforeMove because we can't be sure it moved (in cases of undisciplined robot)
+		updateBeforeMove(next);
+
+		return next;
+	}
+};
+
+template <Direction D1, Direction D2, Direction D3, Direction D4>
+constexpr Direction OrderedAlgorithm<D1, D2, D3, D4>::_order[4];
+
+
+#endif //__ORDERED_ALGORITHM__H_
@@ -0,0 +1,91 @@
+#include "ParallelStepper.h"
+
+
+ParallelStepper::ParallelStepper(size_t helpers_)
+{
+	for (size_t i = 0; i < helpers_; ++i)
+	{
+		_threads.push_back(thread(&ParallelStepper::helperLoop, this));
+	}
+}
+
+
+ParallelStepper::~ParallelStepper()
+{
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stop = true;
+	}
+	_started.notify_all();
+
+	for (auto& helper : _threads)
+	{
+		helper.join();
+	}
+}
+
+
+void ParallelStepper::run(size_t count_, void(*job_)(void*, size_t), void* context_)
+{
+	if (_threads.empty() || count_ < 2)
+	{
+		for (size_t i = 0; i < count_; ++i)
+		{
+			job_(context_, i);
+		}
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(_mutex);
+		_job = job_;
+		_context = context_;
+		_count = count_;
+		_next = 0;
+		_working = _threads.size();
+		++_epoch;
+	}
+	_started.notify_all();
+
+	work();
+
+	// barrier - the helpers are done with this epoch
+	unique_lock<mutex> lock(_mutex);
+	_finished.wait(lock, [this] { return _working == 0; });
+}
+
+
+void ParallelStepper::work()
+{
+	for (size_t i = _next++; i < _count; i = _next++)
+	{
+		_job(_context, i);
+	}
+}
+
+
+void ParallelStepper::helperLoop()
+{
+	size_t seenEpoch = 0;
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(_mutex);
+			_started.wait(lock, [&] { return _stop || _epoch != seenEpoch; });
+			if (_stop) return;
+			seenEpoch = _epoch;
+		}
+
+		work();
+
+		bool last;
+		{
+			lock_guard<mutex> lock(_mutex);
+			last = (--_working == 0);
+		}
+		if (last)
+		{
+			_finished.notify_one();
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef __PARALLEL_STEPPER__H_
+#define __PARALLEL_STEPPER__H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+
+// Helper threads that run one job over a range of indices together with the calling thread (one step of a house at a time).
+// Every run() starts a new epoch the helpers wake up on, and returns once all indices are done (a barrier),
+// so everything before and after it stays sequential.
+class ParallelStepper
+{
+	vector<thread>		_threads;
+	mutex				_mutex;
+	condition_variable	_started;
+	condition_variable	_finished;
+	size_t				_epoch = 0;
+	size_t				_working = 0;	// helpers still in the current epoch
+	bool				_stop = false;
+
+	// current job, doesn't allocate (a plain function and a pointer to the caller's functor)
+	void				(*_job)(void*, size_t) = nullptr;
+	void*				_context = nullptr;
+	size_t				_count = 0;
+	atomic_size_t		_next{ 0 };
+
+public:
+	explicit ParallelStepper(size_t helpers_);
+	~ParallelStepper();
+
+	ParallelStepper(const ParallelStepper&) = delete;
+	ParallelStepper& operator=(const ParallelStepper&) = delete;
+
+	size_t threadsCount() const { return _threads.size() + 1; }
+
+	// job_(i) for every i in [0, count_)
+	template <class Job>
+	void run(size_t count_, Job& job_)
+	{
+		run(count_, [](void* context, size_t i) { (*static_cast<Job*>(context))(i); }, &job_);
+	}
+
+private:
+	void run(size_t count_, void(*job_)(void*, size_t), void* context_);
+	void work();
+	void helperLoop();
+};
+
+
+#endif //__PARALLEL_STEPPER__H_
@@ -11,17 +11,37 @@ const char* const ParamsParser::_options[] = {
 	"-house_path",
 	"-algorithm_path",
 	"-score_formula",
-	"-threads"
+	"-threads",
+	"-fast_forward",
+	"-latency_json",
+	"-timeline",
+	"-profile",
+	"-benchmark_runs",
+	"-benchmark_json",
+	"-scaling_cells",
+	"-house_gen",
+	"-write_house_pack"
 };
 
 
 const char* const ParamsParser::_flags[] = {
-	"-video"
+	"-video",
+	"-alloc_count",
+	"-fast_forward_verify",
+	"-reachable_done",
+	"-early_abandon",
+	"-latency",
+	"-perf",
+	"-alloc_profile",
+	"-benchmark",
+	"-thread_sweep",
+	"-scaling",
+	"-stream"
 };
 
 
 bool ParamsParser::_wasUsageMessagePrinted = false;
-const char* ParamsParser::_usageMessage = "Usage: simulator [-config <config path>] [-house_path <house path>] [-algorithm_path <algorithm path>] [-score_formula <score .so path>] [-threads <num threads>] [-video]";
+const char* ParamsParser::_usageMessage = "Usage: simulator [-config <config path>] [-house_path <house path | .hpack path> | -house_gen <kind>:<W>x<H>:<count>:<seed>[:<option>=<value>...]] [-stream] [-algorithm_path <algorithm path>] [-score_formula <score .so path>] [-threads <num threads>] [-video] [-alloc_count] [-fast_forward <idle steps>] [-fast_forward_verify] [-reachable_done] [-early_abandon] [-latency] [-latency_json <json path>] [-perf] [-alloc_profile] [-timeline <json path>] [-profile <collapsed stacks path>] [-benchmark] [-benchmark_runs <runs>] [-benchmark_json <json path>] [-thread_sweep] [-scaling] [-scaling_cells <max cells>] [-write_house_pack <.hpack path>]";
 
 
 ParamsParser::ParamsParser(int argc, char* argv[])
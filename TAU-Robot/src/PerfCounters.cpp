@@ -0,0 +1,148 @@
+#include "PerfCounters.h"
+
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+
+atomic_bool PerfCounters::_enabled(false);
+
+
+PerfSample& PerfSample::operator+=(const PerfSample& other_)
+{
+	cycles += other_.cycles;
+	instructions += other_.instructions;
+	cacheMisses += other_.cacheMisses;
+	branchMisses += other_.branchMisses;
+	return *this;
+}
+
+
+PerfSample PerfSample::operator-(const PerfSample& other_) const
+{
+	PerfSample diff;
+	diff.cycles = cycles - other_.cycles;
+	diff.instructions = instructions - other_.instructions;
+	diff.cacheMisses = cacheMisses - other_.cacheMisses;
+	diff.branchMisses = branchMisses - other_.branchMisses;
+	return diff;
+}
+
+
+#ifdef __linux__
+namespace
+{
+	const uint64_t events[] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+	const int EVENTS = sizeof(events) / sizeof(*events);
+
+	// one counter group per thread, read with a single read()
+	struct ThreadCounters
+	{
+		int		fds[EVENTS];
+		bool	opened = false;
+		int		error = 0;
+
+		ThreadCounters()
+		{
+			for (int i = 0; i < EVENTS; ++i) fds[i] = -1;
+
+			for (int i = 0; i < EVENTS; ++i)
+			{
+				perf_event_attr attr;
+				memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = events[i];
+				attr.disabled = (i == 0);
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP;
+
+				fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : fds[0], 0);
+				if (fds[i] < 0)
+				{
+					error = errno;
+					close();
+					return;
+				}
+			}
+
+			ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+			opened = true;
+		}
+
+		~ThreadCounters() { close(); }
+
+		void close()
+		{
+			for (int i = 0; i < EVENTS; ++i)
+			{
+				if (fds[i] >= 0) ::close(fds[i]);
+				fds[i] = -1;
+			}
+		}
+
+		PerfSample read() const
+		{
+			PerfSample sample;
+			uint64_t values[1 + EVENTS];
+			if (opened && ::read(fds[0], values, sizeof(values)) == (ssize_t)sizeof(values))
+			{
+				sample.cycles = values[1];
+				sample.instructions = values[2];
+				sample.cacheMisses = values[3];
+				sample.branchMisses = values[4];
+			}
+			return sample;
+		}
+	};
+
+	ThreadCounters& threadCounters()
+	{
+		thread_local ThreadCounters counters;
+		return counters;
+	}
+}
+
+
+bool PerfCounters::enable(string& why_)
+{
+	ThreadCounters& counters = threadCounters();
+	if (!counters.opened)
+	{
+		why_ = strerror(counters.error);
+		return false;
+	}
+
+	_enabled = true;
+	return true;
+}
+
+
+PerfSample PerfCounters::read()
+{
+	return threadCounters().read();
+}
+
+#else
+
+bool PerfCounters::enable(string& why_)
+{
+	why_ = "perf_event_open is Linux only";
+	return false;
+}
+
+
+PerfSample PerfCounters::read()
+{
+	return PerfSample();
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __PERF_COUNTERS__H_
+#define __PERF_COUNTERS__H_
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+
+// hardware counter values (or differences of them)
+struct PerfSample
+{
+	uint64_t	cycles = 0;
+	uint64_t	instructions = 0;
+	uint64_t	cacheMisses = 0;
+	uint64_t	branchMisses = 0;
+
+	PerfSample& operator+=(const PerfSample& other_);
+	PerfSample operator-(const PerfSample& other_) const;
+
+	double ipc() const { return cycles > 0 ? (double)instructions / cycles : 0.0; }
+	double perKiloInstructions(uint64_t events_) const { return instructions > 0 ? 1000.0 * events_ / instructions : 0.0; }
+};
+
+
+// Hardware counters of the calling thread (cycles, instructions, cache misses, branch misses) via perf_event_open,
+// user space only. Every thread opens its own counters the first time it reads them.
+// Off unless enable() succeeded (-perf) - it fails where there are no counters (not Linux, containers / VMs without a PMU,
+// perf_event_paranoid), and the simulator then runs without them.
+class PerfCounters
+{
+	static atomic_bool	_enabled;
+
+public:
+	// false (and why_) if the counters can't be opened
+	static bool enable(string& why_);
+	static bool isEnabled() { return _enabled; }
+
+	// the calling thread's counters so far (zeros if its counters couldn't be opened)
+	static PerfSample read();
+};
+
+
+#endif //__PERF_COUNTERS__H_
@@ -0,0 +1,59 @@
+#include "PlanRunner.h"
+
+
+void PlanRunner::attach(AbstractAlgorithm* algo_)
+{
+	_planner = dynamic_cast<PlanningAlgorithm*>(algo_);
+	dropPlan();
+	_planInfos.clear();
+}
+
+
+Direction PlanRunner::nextMove(AbstractAlgorithm& algo_, Direction prevStep_, const SensorInformation& info_, int battery_)
+{
+	bool interrupted = (battery_ < _plan.batteryThreshold) || (_plan.interruptOnDirt && info_.dirtLevel > 0);
+	if (_planIndex < _plan.moves.size() && !interrupted)
+	{
+		_planInfos.push_back(info_);
+		return _plan.moves[_planIndex++];
+	}
+
+	reportPlan();
+	dropPlan();
+
+	Direction stepDirection = algo_.step(prevStep_);
+	if (_planner != nullptr && !_planner->plan(_plan))
+	{
+		_plan.moves.clear();
+	}
+	return stepDirection;
+}
+
+
+void PlanRunner::aboutToFinish(AbstractAlgorithm& algo_, int stepsTillFinishing_)
+{
+	// the algorithm has to be up to date with the planned moves made so far
+	reportPlan();
+	if (_plan.interruptOnAboutToFinish)
+	{
+		dropPlan();
+	}
+	algo_.aboutToFinish(stepsTillFinishing_);
+}
+
+
+void PlanRunner::reportPlan()
+{
+	if (!_planInfos.empty())
+	{
+		_planner->planExecuted(_planInfos);
+		_planInfos.clear();
+	}
+}
+
+
+void PlanRunner::dropPlan()
+{
+	_plan.moves.clear();
+	_planIndex = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef __PLAN_RUNNER__H_
+#define __PLAN_RUNNER__H_
+
+#include <vector>
+using namespace std;
+
+#include "Direction.h"
+#include "AbstractAlgorithm.h"
+#include "PlanningAlgorithm.h"
+
+
+// Gets a robot's moves from its algorithm - from a plan while there is one (see PlanningAlgorithm), otherwise by calling step()
+class PlanRunner
+{
+	PlanningAlgorithm*			_planner = nullptr;
+	MovePlan					_plan;
+	size_t						_planIndex = 0;
+	vector<SensorInformation>	_planInfos;
+
+public:
+	void attach(AbstractAlgorithm* algo_);
+
+	// info_ - what the robot's sensor shows now, battery_ - the robot's battery after this step was charged / paid for
+	// (both engines do that before asking for the move)
+	Direction nextMove(AbstractAlgorithm& algo_, Direction prevStep_, const SensorInformation& info_, int battery_);
+	void aboutToFinish(AbstractAlgorithm& algo_, int stepsTillFinishing_);
+
+private:
+	void reportPlan();
+	void dropPlan();
+};
+
+
+#endif //__PLAN_RUNNER__H_
@@ -0,0 +1,37 @@
+#ifndef __PLANNING_ALGORITHM__H_
+#define __PLANNING_ALGORITHM__H_
+
+#include <vector>
+using namespace std;
+
+#include "Direction.h"
+#include "SensorInformation.h"
+
+
+// the moves of the next steps, made by the simulation without calling step()
+struct MovePlan
+{
+	vector<Direction>	moves;							// in the order they are made
+	int					batteryThreshold = 0;			// stop before a step that leaves less battery (charged / paid for, before the move)
+	bool				interruptOnDirt = false;		// stop before a step that starts on dirt
+	bool				interruptOnAboutToFinish = true;// drop the rest of the plan when aboutToFinish is called
+};
+
+
+// Optional extension of AbstractAlgorithm (detected with dynamic_cast).
+// After every step() the simulation asks for a plan. While there is one, its moves are made one per step,
+// and once it ends (or is interrupted) the algorithm gets the sensor information it missed, before the next step().
+class PlanningAlgorithm
+{
+public:
+	virtual ~PlanningAlgorithm() {}
+
+	// fills plan_ (moves are empty when called), returns false if there's no plan
+	virtual bool plan(MovePlan& plan_) = 0;
+
+	// the first infos_.size() moves of the plan were made, infos_[i] is what the sensor showed at the beginning of move i
+	virtual void planExecuted(const vector<SensorInformation>& infos_) = 0;
+};
+
+
+#endif //__PLANNING_ALGORITHM__H_
@@ -4,7 +4,6 @@
 
 #include <cmath>
 #include <iostream>
-#include <functional>
 
 #include "Direction.h"
 
@@ -26,14 +25,13 @@ public:
 
 	void print(ostream& out = cout) const { out << "(" << _x << "," << _y << ")"; }
 	void move(Direction d) {
-		const static function<void(Point&)> do_move[] = {
-			[](Point&p){++p._x; },	// East
-			[](Point&p){--p._x; },	// West
-			[](Point&p){++p._y; },	// South
-			[](Point&p){--p._y; },	// North
-			[](Point&p){}			// Stay
-		};
-		do_move[(int)d](*this);
+		switch (d) {
+			case Direction::East: ++_x; break;
+			case Direction::West: --_x; break;
+			case Direction::South: ++_y; break;
+			case Direction::North: --_y; break;
+			case Direction::Stay: break;
+		}
 	}
 	bool operator==(const Point& other) const { return (_x == other._x && _y == other._y); }
 	bool operator!=(const Point& other) const { return (_x != other._x || _y != other._y); }
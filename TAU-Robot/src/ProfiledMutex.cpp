@@ -0,0 +1,144 @@
+#include "ProfiledMutex.h"
+#include "Timeline.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+atomic_bool ProfiledMutex::_statsEnabled(false);
+
+
+namespace
+{
+	uint64_t now()
+	{
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// all the ProfiledMutex objects alive
+	mutex& registryMutex()
+	{
+		static mutex registryMutex;
+		return registryMutex;
+	}
+
+	vector<ProfiledMutex*>& registry()
+	{
+		static vector<ProfiledMutex*> mutexes;
+		return mutexes;
+	}
+}
+
+
+ProfiledMutex::ProfiledMutex(const string& name_, const char* waitName_) : _name(name_), _waitName(waitName_)
+{
+	lock_guard<mutex> lock(registryMutex());
+	registry().push_back(this);
+}
+
+
+ProfiledMutex::~ProfiledMutex()
+{
+	lock_guard<mutex> lock(registryMutex());
+	vector<ProfiledMutex*>& mutexes = registry();
+	mutexes.erase(std::remove(mutexes.begin(), mutexes.end(), this), mutexes.end());
+}
+
+
+void ProfiledMutex::lock()
+{
+	if (!_statsEnabled && !Timeline::isEnabled())
+	{
+		_mutex.lock();
+		return;
+	}
+
+	if (!_mutex.try_lock())
+	{
+		Timeline::Span wait(_waitName);
+		uint64_t start = _statsEnabled ? now() : 0;
+		_mutex.lock();
+		if (_statsEnabled)
+		{
+			_contended.fetch_add(1, memory_order_relaxed);
+			_waitTime.fetch_add(now() - start, memory_order_relaxed);
+		}
+	}
+
+	if (_statsEnabled)
+	{
+		_acquisitions.fetch_add(1, memory_order_relaxed);
+		_lockedAt = now();
+	}
+}
+
+
+bool ProfiledMutex::try_lock()
+{
+	if (!_mutex.try_lock()) return false;
+
+	if (_statsEnabled)
+	{
+		_acquisitions.fetch_add(1, memory_order_relaxed);
+		_lockedAt = now();
+	}
+	return true;
+}
+
+
+void ProfiledMutex::unlock()
+{
+	if (_statsEnabled && _lockedAt > 0)
+	{
+		uint64_t hold = now() - _lockedAt;
+		if (hold > _maxHold.load(memory_order_relaxed))
+		{
+			_maxHold.store(hold, memory_order_relaxed); // only the owner writes it
+		}
+		_lockedAt = 0;
+	}
+	_mutex.unlock();
+}
+
+
+LockStats ProfiledMutex::getStats() const
+{
+	LockStats stats;
+	stats.name = _name;
+	stats.acquisitions = _acquisitions;
+	stats.contended = _contended;
+	stats.waitTime = _waitTime;
+	stats.maxHold = _maxHold;
+	return stats;
+}
+
+
+void ProfiledMutex::resetStats()
+{
+	_acquisitions = 0;
+	_contended = 0;
+	_waitTime = 0;
+	_maxHold = 0;
+}
+
+
+vector<LockStats> ProfiledMutex::allStats()
+{
+	lock_guard<mutex> lock(registryMutex());
+	vector<LockStats> stats;
+	for (ProfiledMutex* profiled : registry())
+	{
+		stats.push_back(profiled->getStats());
+	}
+	return stats;
+}
+
+
+void ProfiledMutex::resetAllStats()
+{
+	lock_guard<mutex> lock(registryMutex());
+	for (ProfiledMutex* profiled : registry())
+	{
+		profiled->resetStats();
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef __PROFILED_MUTEX__H_
+#define __PROFILED_MUTEX__H_
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// what a ProfiledMutex went through since its statistics were reset
+struct LockStats
+{
+	string		name;
+	uint64_t	acquisitions = 0;
+	uint64_t	contended = 0;		// acquisitions that had to wait
+	uint64_t	waitTime = 0;		// ns, all the waits
+	uint64_t	maxHold = 0;		// ns, the longest time it was held
+};
+
+
+// A mutex (for lock_guard / unique_lock) that puts its waits on the timeline (-timeline) and counts acquisitions,
+// waits and hold times once enableStats() was called (-thread_sweep). A plain lock / unlock when neither is on.
+// Every ProfiledMutex alive is listed by allStats().
+class ProfiledMutex
+{
+	static atomic_bool	_statsEnabled;
+
+	mutex				_mutex;
+	string				_name;
+	const char*			_waitName;		// timeline event - a string literal
+	atomic<uint64_t>	_acquisitions{0};
+	atomic<uint64_t>	_contended{0};
+	atomic<uint64_t>	_waitTime{0};
+	atomic<uint64_t>	_maxHold{0};
+	uint64_t			_lockedAt = 0;	// written by the owner only
+
+public:
+	ProfiledMutex(const string& name_, const char* waitName_);
+	~ProfiledMutex();
+
+	ProfiledMutex(const ProfiledMutex&) = delete;
+	ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+	void lock();
+	bool try_lock();
+	void unlock();
+
+	LockStats getStats() const;
+	void resetStats();
+
+	static void enableStats() { _statsEnabled = true; }
+	static bool isStatsEnabled() { return _statsEnabled; }
+	static vector<LockStats> allStats();
+	static void resetAllStats();
+};
+
+
+#endif //__PROFILED_MUTEX__H_
@@ -0,0 +1,242 @@
+#include "Profiler.h"
+#include "AlgorithmRegistrar.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#endif
+
+
+atomic_bool Profiler::_running(false);
+int Profiler::_intervalMicros = 0;
+map<string, size_t> Profiler::_samplesPerAlgorithm;
+
+
+#ifdef __linux__
+namespace
+{
+	enum { MAX_SAMPLES = 1 << 16, MAX_DEPTH = 48, HANDLER_FRAMES = 2 };
+
+	struct Sample
+	{
+		int		depth;
+		void*	frames[MAX_DEPTH];
+	};
+
+	// allocated by start() - the signal handler can't allocate
+	vector<Sample> samples;
+	atomic<size_t> taken(0);	// samples[taken] is the next one (taken > MAX_SAMPLES - some were dropped)
+
+	void onSignal(int)
+	{
+		if (!Profiler::isRunning()) return;
+
+		int savedErrno = errno;
+		size_t i = taken.fetch_add(1, memory_order_relaxed);
+		if (i < MAX_SAMPLES)
+		{
+			samples[i].depth = backtrace(samples[i].frames, MAX_DEPTH);
+		}
+		errno = savedErrno;
+	}
+
+	struct Frame
+	{
+		string	name;		// module`function
+		string	algorithm;	// "" outside the algorithms' shared objects
+	};
+
+	Frame symbolize(void* address, const void* simulatorBase)
+	{
+		Frame frame;
+		Dl_info info;
+		if (dladdr(address, &info) == 0 || info.dli_fname == NULL)
+		{
+			char unknown[32];
+			snprintf(unknown, sizeof(unknown), "?`%p", address);
+			frame.name = unknown;
+			return frame;
+		}
+
+		frame.algorithm = AlgorithmRegistrar::getInstance().getAlgorithmNameAt(address);
+
+		string module = info.dli_fname;
+		size_t slash = module.find_last_of('/');
+		if (info.dli_fbase == simulatorBase) module = "simulator";
+		else if (slash != string::npos) module = module.substr(slash + 1);
+
+		string function;
+		if (info.dli_sname != NULL)
+		{
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+			function = (status == 0 && demangled != NULL) ? demangled : info.dli_sname;
+			free(demangled);
+		}
+		else
+		{
+			char offset[32];
+			snprintf(offset, sizeof(offset), "+0x%lx", (unsigned long)((const char*)address - (const char*)info.dli_fbase));
+			function = offset;
+		}
+
+		frame.name = module + "`" + function;
+		for (char& c : frame.name)
+		{
+			if (c == ';' || c == '\n') c = ':'; // collapsed-stack separators
+		}
+		return frame;
+	}
+}
+
+
+bool Profiler::start(int intervalMicros_, string& why_)
+{
+	samples.assign(MAX_SAMPLES, Sample());
+	taken = 0;
+	_intervalMicros = intervalMicros_;
+
+	// the first backtrace() loads libgcc - not something to do in a signal handler
+	void* warmUp[1];
+	backtrace(warmUp, 1);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onSignal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, NULL) != 0)
+	{
+		why_ = strerror(errno);
+		return false;
+	}
+
+	_running = true;
+	struct itimerval timer;
+	timer.it_interval.tv_sec = intervalMicros_ / 1000000;
+	timer.it_interval.tv_usec = intervalMicros_ % 1000000;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+	{
+		why_ = strerror(errno);
+		_running = false;
+		signal(SIGPROF, SIG_IGN);
+		return false;
+	}
+
+	return true;
+}
+
+
+void Profiler::stop()
+{
+	if (!_running) return;
+
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+	_running = false;
+	signal(SIGPROF, SIG_IGN); // drops a signal still pending
+}
+
+
+bool Profiler::write(const string& path_)
+{
+	Dl_info self;
+	const void* simulatorBase = (dladdr((void*)&onSignal, &self) != 0) ? self.dli_fbase : NULL;
+
+	map<void*, Frame> frames;
+	map<string, size_t> stacks;
+	_samplesPerAlgorithm.clear();
+
+	size_t count = min((size_t)taken, (size_t)MAX_SAMPLES);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Sample& sample = samples[i];
+		string root = "simulator";
+		string stack;
+
+		// outermost first; frame HANDLER_FRAMES is where the signal hit, the ones after it are return addresses
+		for (int f = sample.depth - 1; f >= HANDLER_FRAMES; --f)
+		{
+			void* address = (f == HANDLER_FRAMES) ? sample.frames[f] : (void*)((char*)sample.frames[f] - 1);
+			auto cached = frames.find(address);
+			if (cached == frames.end())
+			{
+				cached = frames.insert(make_pair(address, symbolize(address, simulatorBase))).first;
+			}
+
+			if (root == "simulator" && !cached->second.algorithm.empty())
+			{
+				root = cached->second.algorithm;
+			}
+			stack += ";" + cached->second.name;
+		}
+
+		++stacks[root + stack];
+		++_samplesPerAlgorithm[root];
+	}
+
+	ofstream out(path_);
+	if (!out.is_open()) return false;
+
+	for (auto it = stacks.cbegin(); it != stacks.cend(); ++it)
+	{
+		out << it->first << " " << it->second << "\n";
+	}
+
+	return out.good();
+}
+
+
+void Profiler::printSummary()
+{
+	size_t count = min((size_t)taken, (size_t)MAX_SAMPLES);
+	cout << endl << "CPU profile (" << count << " samples of CPU time, every " << _intervalMicros << "us or every kernel tick if that's longer):" << endl;
+	for (auto it = _samplesPerAlgorithm.cbegin(); it != _samplesPerAlgorithm.cend(); ++it)
+	{
+		printf("%-13s %6.2f%%\n", it->first.c_str(), count > 0 ? 100.0 * it->second / count : 0.0);
+	}
+	if (taken > MAX_SAMPLES)
+	{
+		cout << "(" << taken - MAX_SAMPLES << " samples dropped - the buffer was full)" << endl;
+	}
+}
+
+#else
+
+bool Profiler::start(int intervalMicros_, string& why_)
+{
+	why_ = "SIGPROF sampling is Linux only";
+	return false;
+}
+
+
+void Profiler::stop()
+{
+}
+
+
+bool Profiler::write(const string& path_)
+{
+	return false;
+}
+
+
+void Profiler::printSummary()
+{
+}
+
+#endif
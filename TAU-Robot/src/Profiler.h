@@ -0,0 +1,38 @@
+#ifndef __PROFILER__H_
+#define __PROFILER__H_
+
+#include <cstddef>
+#include <atomic>
+#include <map>
+#include <string>
+
+using namespace std;
+
+
+// Sampling CPU profiler (-profile <file>): a SIGPROF every intervalMicros_ of the process' CPU time, the signal handler
+// copies the stack of the thread it interrupted (whichever worker was running) into a preallocated buffer.
+// The timer can't fire more often than the kernel's tick (often 4ms) - the shares are right, the sample count is lower.
+// write() symbolizes the frames (dladdr - the simulator is linked with -rdynamic) and writes them in collapsed-stack
+// format ("root;frame;frame count", for flamegraph.pl / speedscope) - frames are "module`function", the module being
+// the algorithm's .so (found via the AlgorithmRegistrar) or the simulator, and the root is the algorithm the sample was
+// taken in (its outermost frame inside an algorithm .so), "simulator" for the rest.
+// No root, no external profiler - Linux only.
+class Profiler
+{
+	static atomic_bool			_running;
+	static int					_intervalMicros;
+	static map<string, size_t>	_samplesPerAlgorithm;
+
+public:
+	// false (and why_) if the timer / signal handler can't be set
+	static bool start(int intervalMicros_, string& why_);
+	static void stop();
+	static bool isRunning() { return _running; }
+
+	// after stop()
+	static bool write(const string& path_);
+	static void printSummary();
+};
+
+
+#endif //__PROFILER__H_
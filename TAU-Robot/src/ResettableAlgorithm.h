@@ -0,0 +1,17 @@
+#ifndef __RESETTABLE_ALGORITHM__H_
+#define __RESETTABLE_ALGORITHM__H_
+
+
+// Optional extension of AbstractAlgorithm (detected with dynamic_cast).
+// An algorithm implementing it is reused for the next house instead of being constructed again.
+class ResettableAlgorithm
+{
+public:
+	virtual ~ResettableAlgorithm() {}
+
+	// back to the state of a newly constructed instance, setSensor and setConfiguration are called after it as usual
+	virtual void reset() = 0;
+};
+
+
+#endif //__RESETTABLE_ALGORITHM__H_
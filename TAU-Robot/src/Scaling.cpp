@@ -0,0 +1,99 @@
+#include "Scaling.h"
+
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+
+
+const double ScalingReport::SUPERLINEAR_EXPONENT = 0.25;
+
+
+ScalingFit ScalingReport::fit(const vector<double>& x_, const vector<double>& y_)
+{
+	vector<double> logX, logY;
+	for (size_t i = 0; i < x_.size() && i < y_.size(); ++i)
+	{
+		if (x_[i] > 0.0 && y_[i] > 0.0)
+		{
+			logX.push_back(log(x_[i]));
+			logY.push_back(log(y_[i]));
+		}
+	}
+
+	ScalingFit result;
+	size_t n = logX.size();
+	if (n < 2) return result;
+
+	double meanX = 0.0, meanY = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		meanX += logX[i];
+		meanY += logY[i];
+	}
+	meanX /= n;
+	meanY /= n;
+
+	double sxx = 0.0, sxy = 0.0, syy = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		sxx += (logX[i] - meanX) * (logX[i] - meanX);
+		sxy += (logX[i] - meanX) * (logY[i] - meanY);
+		syy += (logY[i] - meanY) * (logY[i] - meanY);
+	}
+	if (sxx == 0.0) return result;
+
+	result.exponent = sxy / sxx;
+	result.r2 = (syy > 0.0) ? (sxy * sxy) / (sxx * syy) : 1.0;
+	return result;
+}
+
+
+void ScalingReport::print() const
+{
+	if (algorithms.empty()) return;
+
+	cout << "Scaling: " << algorithms.size() << " algorithms, " << algorithms.begin()->second.size() << " generated houses of doubling area" << endl;
+
+	vector<string> superlinear;
+	for (const auto& algorithm : algorithms)
+	{
+		cout << endl << algorithm.first << ":" << endl;
+		printf("%11s %10s %10s %14s %14s\n", "house", "cells", "steps", "ns / step", "allocs / step");
+
+		vector<double> cells, stepTimes, stepAllocations;
+		for (const ScalingPoint& point : algorithm.second)
+		{
+			string size = to_string(point.rows) + "x" + to_string(point.cols);
+			printf("%11s %10zu %10llu %14.1f %14.2f\n", size.c_str(), point.cells(), (unsigned long long)point.steps, point.stepTime, point.stepAllocations);
+
+			cells.push_back((double)point.cells());
+			stepTimes.push_back(point.stepTime);
+			stepAllocations.push_back(point.stepAllocations + 1.0); // allocation free steps fit too
+		}
+
+		ScalingFit time = fit(cells, stepTimes);
+		ScalingFit allocations = fit(cells, stepAllocations);
+		bool isSuperlinear = time.exponent > SUPERLINEAR_EXPONENT || allocations.exponent > SUPERLINEAR_EXPONENT;
+		printf("  per step: time ~ cells^%.2f (r2 %.2f), allocations ~ cells^%.2f (r2 %.2f)%s\n", time.exponent, time.r2, allocations.exponent, allocations.r2,
+			isSuperlinear ? " - SUPERLINEAR" : "");
+		if (isSuperlinear)
+		{
+			superlinear.push_back(algorithm.first);
+		}
+	}
+
+	cout << endl;
+	if (superlinear.empty())
+	{
+		cout << "No algorithm's per-step cost grows with the house area (exponent above " << SUPERLINEAR_EXPONENT << ")" << endl;
+	}
+	else
+	{
+		cout << "Superlinear (per-step cost grows with the house area, a house costs more than linear time):";
+		for (const string& name : superlinear)
+		{
+			cout << " " << name;
+		}
+		cout << endl;
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef __SCALING__H_
+#define __SCALING__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// an algorithm on one generated house
+struct ScalingPoint
+{
+	size_t		rows = 0;
+	size_t		cols = 0;
+	uint64_t	steps = 0;
+	double		stepTime = 0.0;			// ns, average in the algorithm's step
+	double		stepAllocations = 0.0;	// average per step
+
+	size_t cells() const { return rows * cols; }
+};
+
+
+// cost = c * cells^exponent, least squares in log-log
+struct ScalingFit
+{
+	double	exponent = 0.0;
+	double	r2 = 0.0;	// of the fit in log-log, 1 = a straight line
+};
+
+
+// Per-step cost of the algorithms on generated houses of doubling area (-scaling). Steps grow with the area, so an
+// algorithm whose per-step time grows with it too costs more than linear time per house - flagged superlinear.
+class ScalingReport
+{
+public:
+	// below it the growth is taken as noise (caches, the first steps' share)
+	static const double SUPERLINEAR_EXPONENT;
+
+	map<string, vector<ScalingPoint>>	algorithms;
+
+	void print() const;
+
+	// of y_ by x_, the points where either is not positive are left out
+	static ScalingFit fit(const vector<double>& x_, const vector<double>& y_);
+};
+
+
+#endif //__SCALING__H_
@@ -7,6 +7,7 @@
 class Sensor : public AbstractSensor
 {
 	friend class Simulation;
+	friend class LockstepSimulation;
 
 	SensorInformation _info;
 
@@ -26,11 +26,22 @@ public:
 		if (!isValid()) return NULL;
 		return dlsym(_handle, funcName_);
 	}
+
+	// address_ is inside this shared object's code / data
+	bool contains(const void* address_) const
+	{
+		Dl_info info;
+		void* map = NULL;
+		void* ownMap = NULL;
+		if (!isValid() || dladdr1(address_, &info, &map, RTLD_DL_LINKMAP) == 0) return false;
+		return dlinfo(_handle, RTLD_DI_LINKMAP, &ownMap) == 0 && map == ownMap;
+	}
 #else
 	// for Windows tests only
 	SharedObjectLoader::SharedObjectLoader(const char* soPath_) : _path(soPath_) {}
 	SharedObjectLoader::~SharedObjectLoader() {}
 	void* SharedObjectLoader::getFunctionPointer(const char* funcName_) const { return NULL; }
+	bool SharedObjectLoader::contains(const void* address_) const { return false; }
 #endif
 	
 
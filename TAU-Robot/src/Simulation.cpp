@@ -2,12 +2,19 @@
 #include "Montage.h"
 #include "Encoder.h"
 #include "BoostUtils.h"
+#include "Timeline.h"
 
 #include <algorithm>
 
-Simulation::Simulation(const Configuration& config_, const House& house_, unique_ptr<AbstractAlgorithm>& algo_, string algoName_) : _algoName(algoName_), _house(house_), _config(config_)
+Simulation::Simulation(const Configuration& config_, const House& house_, unique_ptr<AbstractAlgorithm>& algo_, string algoName_, const AllocationProfile* setupProfile_) : _algoName(algoName_), _house(house_), _config(config_)
 {
-	_robot.battery = _config["BatteryCapacity"];
+	// cached, a lookup by name allocates a string every step
+	_batteryCapacity = _config["BatteryCapacity"];
+	_batteryRechargeRate = _config["BatteryRechargeRate"];
+	_batteryConsumptionRate = _config["BatteryConsumptionRate"];
+	_cpuBudget = CpuBudget(_config);
+
+	_robot.battery = _batteryCapacity;
 	_robot.location = _house.getDocking();
 
 	_config = config_;
@@ -15,9 +22,15 @@ Simulation::Simulation(const Configuration& config_, const House& house_, unique
 	_algo = algo_.release();
 
 	this->updateSensor();
-	
+
+	if (setupProfile_ != nullptr)
+	{
+		_allocationProfile.continueFrom(*setupProfile_);
+	}
+	AllocationCounter::Scope allocations(allocationProfile());
 	_algo->setConfiguration(_config.getParams());
 	_algo->setSensor(_sensor);
+	_planRunner.attach(_algo);
 }
 
 Simulation::~Simulation()
@@ -26,6 +39,15 @@ Simulation::~Simulation()
 }
 
 
+unique_ptr<AbstractAlgorithm> Simulation::releaseAlgorithm()
+{
+	unique_ptr<AbstractAlgorithm> algo(_algo);
+	_algo = nullptr;
+	_planRunner.attach(nullptr);
+	return algo;
+}
+
+
 #ifdef _DEBUG_
 void Simulation::makeHimUndisciplened(Direction& direction)
 {
@@ -49,6 +71,20 @@ void Simulation::makeHimUndisciplened(Direction& direction)
 #endif
 
 bool Simulation::step()
+{
+	if (!AllocationCounter::isEnabled())
+	{
+		return makeStep();
+	}
+
+	size_t allocationsBefore = AllocationCounter::count();
+	bool result = makeStep();
+	_allocations.addStep(AllocationCounter::count() - allocationsBefore);
+	return result;
+}
+
+
+bool Simulation::makeStep()
 {
 	if (_robot.battery <= 0)
 	{
@@ -63,23 +99,45 @@ bool Simulation::step()
 	}
 	
 	
-	int capacity = _config["BatteryCapacity"],
-		rechargeRate = _config["BatteryRechargeRate"],
-		consumptionRate = _config["BatteryConsumptionRate"];	
-	
-	
 	// if the robot starts from docking station - charge battery (even if leaves)
 	if (_house.at(_robot.location) == House::DOCKING)
 	{
-		_robot.battery = std::min(capacity, _robot.battery + rechargeRate);
+		_robot.battery = std::min(_batteryCapacity, _robot.battery + _batteryRechargeRate);
 	}
 	else
 	{
-		_robot.battery -= consumptionRate;
+		_robot.battery -= _batteryConsumptionRate;
 	}
 
 	// always make a move if battery is larger than 0 at the beggining
-	Direction stepDirection = _algo->step(_prevStep);
+	uint64_t stepStart = StepClock::isEnabled() ? StepClock::now() : 0;
+	uint64_t cpuStart = _cpuBudget.isSet() ? StepClock::threadCpuTime() : 0;
+	PerfSample perfStart = PerfCounters::isEnabled() ? PerfCounters::read() : PerfSample();
+	Direction stepDirection;
+	{
+		AllocationCounter::Scope allocations(allocationProfile());
+		stepDirection = _planRunner.nextMove(*_algo, _prevStep, _sensor._info, _robot.battery);
+	}
+	if (PerfCounters::isEnabled())
+	{
+		_perf += PerfCounters::read() - perfStart;
+	}
+	if (StepClock::isEnabled())
+	{
+		_latency.add(StepClock::toNanoseconds(StepClock::now() - stepStart));
+	}
+
+	if (_cpuBudget.isSet())
+	{
+		uint64_t stepTime = StepClock::threadCpuTime() - cpuStart;
+		_cpuTime += stepTime;
+		_misbehavior = _cpuBudget.check(stepTime, _cpuTime);
+		if (_misbehavior != Misbehavior::None)
+		{
+			_robot.goodBehavior = false;
+			return false; // too slow, not stepped any more
+		}
+	}
 #ifdef _DEBUG_
 	// makeHimUndisciplened(stepDirection);
 #endif
@@ -95,6 +153,7 @@ bool Simulation::step()
 	// cout << "[INFO] The robot is trying to walk through a wall." << endl;
 #endif
 		_robot.goodBehavior = false;
+		_misbehavior = Misbehavior::Wall;
 		return false; // outside the house / into a wall
 	}
 
@@ -105,9 +164,59 @@ bool Simulation::step()
 }
 
 
+CpuBudget::CpuBudget(const Configuration& config_)
+{
+	step = (uint64_t)config_.get("StepCpuBudgetMicros", 0) * 1000;
+	simulation = (uint64_t)config_.get("SimulationCpuBudgetMillis", 0) * 1000000;
+}
+
+
+Misbehavior CpuBudget::check(uint64_t stepTime_, uint64_t simulationTime_) const
+{
+	if (step > 0 && stepTime_ > step)
+	{
+		return Misbehavior::StepCpuBudget;
+	}
+	if (simulation > 0 && simulationTime_ > simulation)
+	{
+		return Misbehavior::SimulationCpuBudget;
+	}
+	return Misbehavior::None;
+}
+
+
+string describeMisbehavior(Misbehavior misbehavior_)
+{
+	switch (misbehavior_)
+	{
+	case Misbehavior::StepCpuBudget: return "exceeded the CPU time budget of a step";
+	case Misbehavior::SimulationCpuBudget: return "exceeded the CPU time budget of the simulation";
+	default: return "went on a wall";
+	}
+}
+
+
+string describeResultChange(const SimulationResult& expected_, const SimulationResult& actual_)
+{
+	string change;
+	auto compare = [&change](const char* field, int expected, int actual)
+	{
+		if (actual == expected) return;
+		change += string(change.empty() ? "" : ", ") + field + " " + to_string(actual) + " instead of " + to_string(expected);
+	};
+	compare("done", expected_.done, actual_.done);
+	compare("out of battery", expected_.outOfBattery, actual_.outOfBattery);
+	compare("docked", expected_.docked, actual_.docked);
+	compare("steps", expected_.steps, actual_.steps);
+	compare("total dirt", expected_.totalDirt, actual_.totalDirt);
+	compare("dirt", expected_.cleanedDirt, actual_.cleanedDirt);
+	return change;
+}
+
+
 bool Simulation::isDone() const
 {
-	return _house.isClean() && (_robot.location == _house.getDocking());
+	return (_house.getDirtAmount() <= _dirtLeftWhenDone) && (_robot.location == _house.getDocking());
 }
 
 
@@ -130,7 +239,8 @@ void Simulation::printStatus()
 
 void Simulation::CallAboutToFinish(int stepsTillFinishing)
 {
-	_algo->aboutToFinish(stepsTillFinishing);
+	AllocationCounter::Scope allocations(allocationProfile());
+	_planRunner.aboutToFinish(*_algo, stepsTillFinishing);
 }
 
 
@@ -178,6 +288,28 @@ bool Simulation::Compare(const Simulation* simu, const Simulation* other)
 	return (*simu)<(*other);
 }
 
+SimulationResult Simulation::getResult() const
+{
+	SimulationResult result;
+	result.algoName = _algoName;
+	result.done = isDone();
+	result.outOfBattery = isRobotOutOfBattery();
+	result.docked = isRobotDocked();
+	result.steps = getStepsCount();
+	result.totalDirt = getTotalDirtCount() - _dirtLeftWhenDone;
+	result.cleanedDirt = getCleanedDirtCount();
+	return result;
+}
+
+bool SimulationResult::Compare(const SimulationResult& result_, const SimulationResult& other_)
+{
+	if (result_.done == other_.done)
+	{
+		return (result_.steps < other_.steps);
+	}
+	return (result_.done && !other_.done);
+}
+
 void Simulation::updateSensor()
 {
 	char state = _house.at(_robot.location);
@@ -201,6 +333,7 @@ void Simulation::updateSensor()
 
 void Simulation::createMontage()
 {
+	Timeline::Span span("montage");
 	string imagesDirPath = "./IMG_" + _algoName + "_" + _house.getFilenameWithoutSuffix();
 
 	if (_montageCounter == 0)
@@ -231,6 +364,7 @@ void Simulation::createMontage()
 
 void Simulation::createMontageVideo()
 {
+	Timeline::Span span("encode video");
 	string imagesDirPath = "./IMG_" + _algoName + "_" + _house.getFilenameWithoutSuffix() + "/";
 
 	if (boost::filesystem::is_directory(imagesDirPath))
@@ -6,9 +6,55 @@
 #include "House.h"
 #include "Sensor.h"
 #include "Configuration.h"
+#include "AllocationCounter.h"
+#include "StepLatency.h"
+#include "PerfCounters.h"
+#include "PlanRunner.h"
 
 #include <memory>
 
+
+// what a simulation is scored by
+struct SimulationResult
+{
+	string	algoName;
+	bool	done = false;			// clean house and back in docking
+	bool	outOfBattery = false;
+	bool	docked = false;
+	int		steps = 0;
+	int		totalDirt = 0;				// without the dirt out of reach, when it doesn't count
+	int		cleanedDirt = 0;
+
+	// smaller = done with less steps
+	static bool Compare(const SimulationResult& result_, const SimulationResult& other_);
+};
+
+
+// why a robot was stopped for misbehaving
+enum class Misbehavior { None, Wall, StepCpuBudget, SimulationCpuBudget };
+
+// completes "Algorithm X when running on House Y ... in step N"
+string describeMisbehavior(Misbehavior misbehavior_);
+
+// the fields of actual_ that differ from expected_ ("docked 0 instead of 1, ..."), empty if it's the same result
+string describeResultChange(const SimulationResult& expected_, const SimulationResult& actual_);
+
+
+// CPU time an algorithm may use (config.ini StepCpuBudgetMicros / SimulationCpuBudgetMillis, 0 or missing = unlimited)
+struct CpuBudget
+{
+	uint64_t	step = 0;			// ns
+	uint64_t	simulation = 0;		// ns
+
+	CpuBudget() = default;
+	explicit CpuBudget(const Configuration& config_);
+
+	bool isSet() const { return (step > 0) || (simulation > 0); }
+	// Misbehavior::None if a step of stepTime_ (simulationTime_ in total so far) is within the budget
+	Misbehavior check(uint64_t stepTime_, uint64_t simulationTime_) const;
+};
+
+
 class Simulation
 {
 	AbstractAlgorithm*	_algo = nullptr;
@@ -18,15 +64,28 @@ class Simulation
 	RobotInformation	_robot;
 	Configuration		_config;
 	Direction			_prevStep = Direction::Stay;
+	int					_batteryCapacity = 0;
+	int					_batteryRechargeRate = 0;
+	int					_batteryConsumptionRate = 0;
+	int					_dirtLeftWhenDone = 0;	// dirt no robot can get to, the house counts as clean without it
 	
 	int					_montageCounter = 0;
 	int					_montageFailedCounter = 0;
 	vector<string>		_montageErrors;
+	AllocationStats		_allocations;
+	AllocationProfile	_allocationProfile;	// inside the algorithm's calls, only with -alloc_profile
+	LatencyHistogram	_latency;
+	PerfSample			_perf;				// in the algorithm's steps, only with -perf
+	CpuBudget			_cpuBudget;
+	uint64_t			_cpuTime = 0;		// in the algorithm's steps (ns), only measured with a CPU budget
+	Misbehavior			_misbehavior = Misbehavior::None;
+	PlanRunner			_planRunner;
 
 public:
 
 	Simulation() = delete;
-	Simulation(const Configuration& config_, const House& house_, unique_ptr<AbstractAlgorithm>& algo_, string algoName_);
+	// setupProfile_ - the algorithm's setup (-alloc_profile), its profile here goes on after it
+	Simulation(const Configuration& config_, const House& house_, unique_ptr<AbstractAlgorithm>& algo_, string algoName_, const AllocationProfile* setupProfile_ = nullptr);
 	virtual ~Simulation();
 
 	bool step();
@@ -37,17 +96,29 @@ public:
 	bool isRobotDocked() const { return (_robot.location == _house.getDocking()); }
 	bool isRobotOutOfBattery() const { return _robot.stuck; }
 	bool didRobotMisbehave() const { return !_robot.goodBehavior; }
+	Misbehavior getMisbehavior() const { return _misbehavior; }
 	bool isDone() const;
+	void setDirtLeftWhenDone(int dirt_) { _dirtLeftWhenDone = dirt_; }
 	void printStatus();
 	void CallAboutToFinish(int stepsTillFinishing);
+	// the sensor from the robot's location (every step does it)
+	void updateSensor();
 	void createMontage();
 	void createMontageVideo();
 	vector<string> getMontageErrors() const { return _montageErrors; }
+	const AllocationStats& getAllocationStats() const { return _allocations; }
+	const AllocationProfile& getAllocationProfile() const { return _allocationProfile; }
+	const LatencyHistogram& getLatency() const { return _latency; }
+	const PerfSample& getPerf() const { return _perf; }
+
+	// takes the algorithm back (e.g. to reuse it on the next house), the simulation can't step after it
+	unique_ptr<AbstractAlgorithm> releaseAlgorithm();
 
 	static int calc_score(const map<string, int>& score_params_);
 
 
 	RobotInformation getRobotInfo() const { return _robot; }
+	SimulationResult getResult() const;
 
 	// smaller = done with less steps
 	bool operator<(const Simulation& other) const;
@@ -55,7 +126,8 @@ public:
 	static bool Compare(const Simulation* simu, const Simulation* other);
 
 private:
-	void updateSensor();
+	bool makeStep();
+	AllocationProfile* allocationProfile() { return AllocationCounter::isProfiling() ? &_allocationProfile : nullptr; }
 
 
 #ifdef _DEBUG_
@@ -4,10 +4,15 @@
 #include "ParamsParser.h"
 #include "AlgorithmRegistrar.h"
 #include "MakeUnique.h"
+#include "HouseGenerator.h"
+#include "Scaling.h"
 
 #include <algorithm>
+#include <cmath>
 #include <boost/filesystem.hpp>
 #include <thread>
+#include <fstream>
+#include <chrono>
 
 namespace fs = boost::filesystem;
 
@@ -21,7 +26,7 @@ sync_cout sync_cout::_self;
 
 string Simulator::scoreFunctionFileName = "score_formula.so";
 
-Simulator::Simulator(const Configuration& conf_, const char* housePath_, const char* algorithmPath_, const char* scorePath_, const char* threadsCount_, bool createVideos_)
+Simulator::Simulator(const Configuration& conf_, const char* housePath_, const char* algorithmPath_, const char* scorePath_, const char* threadsCount_, bool createVideos_, const char* houseGen_, bool streamHouses_)
 {
 	_config = conf_;
 	_createVideos = createVideos_;
@@ -44,17 +49,32 @@ Simulator::Simulator(const Configuration& conf_, const char* housePath_, const c
 	// Handle Alogs
 	vector<string> algoErrors;
 #ifndef _WINDOWS_
-	if (!getAlgos(algorithmPath_, algoErrors))
+	Timeline::begin("load algorithms");
+	auto algosStart = chrono::steady_clock::now();
+	bool algosLoaded = getAlgos(algorithmPath_, algoErrors);
+	_algorithmsLoadTime = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - algosStart).count();
+	Timeline::end("load algorithms");
+	if (!algosLoaded)
 	{
 		return;
 	}
 #endif
 
 	// Handle Houses
-	if (!getHouses(housePath_))
+	auto housesStart = chrono::steady_clock::now();
+	bool housesLoaded = (houseGen_ != NULL) ? getGeneratedHouses(houseGen_, requestedThreadsCount, streamHouses_) : getHouses(housePath_, requestedThreadsCount, streamHouses_);
+	_housesLoadTime = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - housesStart).count();
+	if (!housesLoaded)
 	{
 		return;
 	}
+	if (!isStreaming())
+	{
+		for (const House* house : _houses)
+		{
+			_houseNames.push_back(house->getFilenameWithoutSuffix());
+		}
+	}
 
 	// Create scores matrix
 	vector<string> algoNames = AlgorithmRegistrar::getInstance().getAlgorithmNames();
@@ -70,7 +90,7 @@ Simulator::Simulator(const Configuration& conf_, const char* housePath_, const c
 	}
 
 	
-	_threadsCount = min(requestedThreadsCount, _houses.size());
+	setThreads(requestedThreadsCount);
 #ifdef _DEBUG_
 	sync_cout::get() << "_threadsCount: " << _threadsCount << endl;
 #endif	
@@ -136,10 +156,29 @@ bool Simulator::getAlgos(const char* algorithmPath_, vector<string>& errors_)
 }
 
 
-bool Simulator::getHouses(const char* housePath_)
+bool Simulator::getHouses(const char* housePath_, size_t threadsCount_, bool stream_)
 {
 	string housePath = string(housePath_ != NULL ? housePath_ : ".");
-	vector<House*> allHouses = loadAllHouses(housePath.c_str());
+	if (StringUtils::endsWith(housePath, ".hpack") && fs::is_regular_file(housePath))
+	{
+		return getPackedHouses(housePath); // mapped already, nothing to stream
+	}
+
+	vector<House*> allHouses;
+	if (stream_)
+	{
+		vector<string> files = loadFilesWithSuffix(housePath.c_str(), ".house");
+		if (files.size() > 0)
+		{
+			setStream(files.size(), [files](size_t index_) { return new House(files[index_].c_str()); },
+				"All house files in target folder '" + BoostUtils::getFullPath(housePath) + "' cannot be opened or are invalid: ");
+			return true;
+		}
+	}
+	else
+	{
+		allHouses = loadAllHouses(housePath.c_str(), threadsCount_);
+	}
 	
 	if (allHouses.size() == 0)
 	{
@@ -172,6 +211,137 @@ bool Simulator::getHouses(const char* housePath_)
 }
 
 
+bool Simulator::getPackedHouses(const string& packPath_)
+{
+	Timeline::Span span("load house pack");
+	_housePack.reset(new HousePack(packPath_.c_str()));
+	if (!_housePack->isValid())
+	{
+		cout << "cannot read house pack '" << BoostUtils::getFullPath(packPath_) << "': " << _housePack->getError() << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < _housePack->size(); ++i)
+	{
+		House* house = _housePack->createHouse(i);
+		if (house == nullptr)
+		{
+			_errors.push_back(fs::path(packPath_).filename().generic_string() + ": house " + to_string(i) + " is damaged");
+			continue;
+		}
+		_houses.push_back(house);
+	}
+
+	if (_houses.size() == 0)
+	{
+		cout << "The house pack '" << BoostUtils::getFullPath(packPath_) << "' has no valid houses: " << endl;
+		printErrors(_errors);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool Simulator::writeHousePack(const char* housePath_, size_t threadsCount_, const char* packPath_)
+{
+	string housePath = string(housePath_ != NULL ? housePath_ : ".");
+	vector<House*> houses = loadAllHouses(housePath.c_str(), threadsCount_);
+	if (houses.size() == 0)
+	{
+		ParamsParser::printUsage();
+		cout << "cannot find house files in '" << BoostUtils::getFullPath(housePath) << "'" << endl;
+		return false;
+	}
+
+	size_t valid = 0;
+	for (const House* house : houses)
+	{
+		if (house->isValid())
+		{
+			++valid;
+		}
+		else
+		{
+			cout << house->getErrorLine() << endl;
+		}
+	}
+
+	string error;
+	bool written = HousePack::write(houses, packPath_, error);
+	if (written)
+	{
+		cout << valid << " of " << houses.size() << " houses written to " << packPath_ << endl;
+	}
+	else
+	{
+		cout << error << endl;
+	}
+
+	clearPointersVector(houses);
+	return written;
+}
+
+
+bool Simulator::getGeneratedHouses(const char* spec_, size_t threadsCount_, bool stream_)
+{
+	HouseGenerator::Spec spec;
+	string error;
+	if (!HouseGenerator::Spec::parse(spec_, spec, error))
+	{
+		ParamsParser::printUsage();
+		cout << "bad -house_gen '" << spec_ << "': " << error << endl;
+		return false;
+	}
+
+	if (stream_)
+	{
+		setStream(spec.count, [spec](size_t index_) { return new House(HouseGenerator::generate(spec, index_)); }, "All the generated houses are invalid: ");
+		return true;
+	}
+
+	// each house has its own seed - generated in parallel, the same houses with any number of threads
+	Timeline::Span span("generate houses");
+	vector<House*> houses(spec.count, nullptr);
+	parallelFor(houses.size(), threadsCount_, [&spec, &houses](size_t index) {
+		houses[index] = new House(HouseGenerator::generate(spec, index));
+	});
+
+	for (House* house : houses)
+	{
+		if (house->isValid())
+		{
+			_houses.push_back(house);
+		}
+		else
+		{
+			_errors.push_back(house->getErrorLine());
+			delete house;
+		}
+	}
+
+	if (_houses.size() == 0)
+	{
+		cout << "All the generated houses are invalid: " << endl;
+		printErrors(_errors);
+		return false;
+	}
+
+	return true;
+}
+
+
+// a slot per item of the source, the valid houses take the first ones as they're made (see produceHouses)
+void Simulator::setStream(size_t count_, const function<House*(size_t)>& source_, const string& allInvalid_)
+{
+	_streamSource = source_;
+	_streamCount = count_;
+	_streamAllInvalid = allInvalid_;
+	_houses.assign(count_, nullptr);
+	_houseNames.resize(count_);
+}
+
+
 bool Simulator::getScoreFunc(const char* scorePath_)
 {
 	if (scorePath_ != NULL)
@@ -243,15 +413,279 @@ size_t Simulator::getThreadsFromString(const char* threads_count) const
 void Simulator::simulate()
 {
 	if (!_successful) return;
+	runTournament();
+
+	if (isStreaming() && _houses.empty())
+	{
+		cout << _streamAllInvalid << endl;
+		printErrors(_streamErrors);
+		return;
+	}
+
+	Timeline::begin("print results");
+	this->printScores();
+
+	if (AllocationCounter::isEnabled())
+	{
+		this->printAllocationStats();
+	}
+
+	if (AllocationCounter::isProfiling())
+	{
+		this->printAllocationProfiles();
+	}
+
+	if (StepClock::isEnabled() && _printLatency)
+	{
+		this->printLatency();
+	}
+
+	if (PerfCounters::isEnabled())
+	{
+		this->printPerf();
+	}
+
+	if (StepClock::isEnabled() && !_latencyJsonPath.empty() && !this->writeLatencyJson(_latencyJsonPath))
+	{
+		_errors.push_back("Cannot write the latency report to " + _latencyJsonPath);
+	}
+
+	if (_reachableDone)
+	{
+		this->printDirtOutOfReach();
+	}
+
+	if (_earlyAbandon)
+	{
+		cout << endl << "Steps saved by early abandonment: " << _abandonedSteps << endl;
+	}
+
+	if (_printScoreError)
+	{
+		_errors.push_back("Score formula could not calculate some scores, see -1 in the results table");
+	}
+
+	_errors.concat(_montageErrors); // insert montage errors
+
+	if (_errors.size() > 0)
+	{
+		cout << endl << "Errors:" << endl;
+		printErrors(_errors);
+	}
+	Timeline::end("print results");
+}
+
+
+void Simulator::benchmark(int runs_, const string& jsonPath_)
+{
+	if (!_successful) return;
+	if (isStreaming())
+	{
+		cout << "cannot benchmark with -stream, the houses are read once" << endl;
+		return;
+	}
+
+	BenchmarkReport report;
+	report.housesLoadTime = _housesLoadTime;
+	report.algorithmsLoadTime = _algorithmsLoadTime;
+	report.houseNames = _houseNames;
+
+	for (int run = 0; run < runs_; ++run)
+	{
+		_latency.clear();
+		_houseLatency.clear();
+		_constructionTime = 0;
+
+		uint64_t start = StepClock::now();
+		runTournament();
+		report.runs.push_back(getBenchmarkRun(StepClock::toNanoseconds(StepClock::now() - start)));
+	}
+
+	report.print();
+	if (!jsonPath_.empty() && !report.writeJson(jsonPath_))
+	{
+		cout << "Cannot write the benchmark report to " << jsonPath_ << endl;
+	}
+
+	if (_errors.size() > 0 || _printScoreError)
+	{
+		cout << endl << "There were errors, run without -benchmark to see them" << endl;
+	}
+}
+
+
+void Simulator::scaling(size_t maxCells_)
+{
+	if (!_successful) return;
+
+	const size_t FIRST_SIDE = 16;
+	const unsigned SEED = 1;
+
+	// square houses of the same structure, the area doubles from one to the next
+	vector<House> houses;
+	for (int k = 0; ; ++k)
+	{
+		size_t side = (size_t)lround(FIRST_SIDE * pow(2.0, k / 2.0));
+		if (side * side > maxCells_ && k > 0) break;
+		houses.push_back(HouseGenerator::generate("scaling" + to_string(side), side, side, SEED));
+	}
+
+	ScalingReport report;
+	for (const string& algoName : AlgorithmRegistrar::getInstance().getAlgorithmNames())
+	{
+		for (House& house : houses)
+		{
+			house.findDockingDistances();
+
+			// a battery that reaches the whole house, or the bigger houses are only the docking station's surroundings
+			Configuration config(_config);
+			config["BatteryCapacity"] = max(config["BatteryCapacity"], (int)(4 * (house.getXSize() + house.getYSize())));
+
+			unique_ptr<AbstractAlgorithm> algorithm = AlgorithmRegistrar::getInstance().createAlgorithm(algoName);
+			Simulation simulation(config, house, algorithm, algoName);
+			simulation.setDirtLeftWhenDone(house.getDirtOutOfReach()); // the generator can wall some dirt in
+			while (simulation.getStepsCount() < (int)house.getMaxSteps() && simulation.step() && !simulation.isDone())
+			{
+			}
+
+			ScalingPoint point;
+			point.rows = house.getYSize();
+			point.cols = house.getXSize();
+			point.steps = simulation.getLatency().count();
+			point.stepTime = point.steps > 0 ? (double)simulation.getLatency().total() / point.steps : 0.0;
+			point.stepAllocations = simulation.getAllocationStats().average();
+			report.algorithms[algoName].push_back(point);
+		}
+	}
+
+	report.print();
+}
+
+
+void Simulator::setThreads(size_t requestedThreadsCount_)
+{
+	_threadsCount = min(requestedThreadsCount_, _houses.size());
+
+	// fewer houses than threads - the spare threads step the algorithms of each house in parallel
+	_houseThreadsCount = min(max(requestedThreadsCount_ / _threadsCount, (size_t)1), AlgorithmRegistrar::getInstance().size());
+}
+
+
+void Simulator::threadSweep(size_t maxThreads_)
+{
+	if (!_successful) return;
+	if (isStreaming())
+	{
+		cout << "cannot sweep the thread counts with -stream, the houses are read once" << endl;
+		return;
+	}
+	if (_createVideos && maxThreads_ > 1)
+	{
+		cout << "cannot create videos with more than 1 thread" << endl;
+		return;
+	}
+
+	vector<size_t> threadCounts;
+	for (size_t threads = 1; threads < maxThreads_; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads_);
+
+	ProfiledMutex::enableStats();
+	cout << "Thread sweep: " << _houses.size() << " houses, " << AlgorithmRegistrar::getInstance().size() << " algorithms, " << thread::hardware_concurrency() << " hardware threads" << endl << endl;
+	printf("%8s %8s %14s %12s %9s %11s\n", "threads", "houses", "house threads", "wall (ms)", "speedup", "efficiency");
+
+	double firstWallTime = 0.0;
+	vector<vector<LockStats>> lockStats;
+	vector<pair<size_t, size_t>> houseIndexStats;
+	for (size_t threads : threadCounts)
+	{
+		setThreads(threads);
+		ProfiledMutex::resetAllStats();
+		_houseIndexFetches = 0;
+		_houseIndexRetries = 0;
+
+		auto start = chrono::steady_clock::now();
+		runTournament();
+		double wallTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0;
+
+		if (firstWallTime == 0.0) firstWallTime = wallTime;
+		double speedup = wallTime > 0.0 ? firstWallTime / wallTime : 0.0;
+		printf("%8zu %8zu %14zu %12.1f %9.2f %10.1f%%\n", threads, _threadsCount, _houseThreadsCount, wallTime, speedup, 100.0 * speedup / threads);
+
+		lockStats.push_back(ProfiledMutex::allStats());
+		houseIndexStats.push_back(make_pair((size_t)_houseIndexFetches, (size_t)_houseIndexRetries));
+	}
+
+	cout << endl << "Lock contention (acquisitions, waited, total wait, longest hold):" << endl;
+	for (size_t i = 0; i < threadCounts.size(); ++i)
+	{
+		cout << threadCounts[i] << (threadCounts[i] == 1 ? " thread:" : " threads:") << endl;
+		for (const LockStats& stats : lockStats[i])
+		{
+			printf("  %-34s %8llu, %6llu, %10.3f ms, %8.3f ms\n", stats.name.c_str(), (unsigned long long)stats.acquisitions, (unsigned long long)stats.contended, stats.waitTime / 1e6, stats.maxHold / 1e6);
+		}
+		printf("  %-34s %8zu fetches, %zu compare-and-swap retries\n", "Simulator::_houseIndex (atomic)", houseIndexStats[i].first, houseIndexStats[i].second);
+	}
+
+	if (_errors.size() > 0 || _printScoreError)
+	{
+		cout << endl << "There were errors, run without -thread_sweep to see them" << endl;
+	}
+}
+
+
+// fetch old value, then add (fetch_add) - as a compare-and-swap loop with the lock statistics on, its retries are the contention
+size_t Simulator::nextHouseIndex()
+{
+	if (isStreaming())
+	{
+		size_t index;
+		return _streamQueue->pop(index) ? index : _houses.size();
+	}
+
+	if (!ProfiledMutex::isStatsEnabled())
+	{
+		return _houseIndex++;
+	}
+
+	size_t index = _houseIndex.load();
+	while (!_houseIndex.compare_exchange_weak(index, index + 1))
+	{
+		++_houseIndexRetries;
+	}
+	++_houseIndexFetches;
+	return index;
+}
+
+
+// all the houses, once
+void Simulator::runTournament()
+{
 	int maxStepsAfterWinner = _config["MaxStepsAfterWinner"];
+	_houseIndex = 0;
+	_houseWallTime.assign(_houses.size(), 0);
+	_houseAlgorithmsPerf.assign(_houses.size(), PerfSample());
+	_houseSimulatorPerf.assign(_houses.size(), PerfSample());
+	_houseThread.assign(_houses.size(), 0);
+	_dirtOutOfReach.assign(_houses.size(), string());
+	_threadWallTime.assign(_threadsCount, 0);
+
+	thread producer;
+	if (isStreaming())
+	{
+		_streamQueue.reset(new BoundedQueue<size_t>(_threadsCount));
+		producer = thread(&Simulator::produceHouses, this);
+	}
 
 	if (_threadsCount > 1)
 	{
 		vector<unique_ptr<thread>> threads(_threadsCount);
-		for (auto& thread_ptr : threads)
+		for (size_t i = 0; i < threads.size(); ++i)
 		{
 			// create the threads and run them
-			thread_ptr = make_unique<thread>(&Simulator::runSingleSubSimulationThread, this, maxStepsAfterWinner); // create and run the thread
+			threads[i] = make_unique<thread>(&Simulator::runSingleSubSimulationThread, this, maxStepsAfterWinner, i); // create and run the thread
 		}
 		// join all the threads
 		for (auto& thread_ptr : threads)
@@ -262,63 +696,373 @@ void Simulator::simulate()
 	else
 	{
 		// Only 1 thread - run on main thread
-		runSingleSubSimulationThread(maxStepsAfterWinner);
+		runSingleSubSimulationThread(maxStepsAfterWinner, 0);
 	}
 
-	this->printScores();
+	if (isStreaming())
+	{
+		producer.join();
+		finishStream();
+	}
+}
 
-	if (_printScoreError)
+
+// -stream: the houses in order, each valid one gets the next index - a full queue holds the producer back, so at most
+// a house per thread waits, one is made and one is simulated by each thread
+void Simulator::produceHouses()
+{
+	size_t valid = 0;
+	for (size_t i = 0; i < _streamCount; ++i)
 	{
-		_errors.push_back("Score formula could not calculate some scores, see -1 in the results table");
+		House* house;
+		{
+			Timeline::Span span("load house", (int)i);
+			house = _streamSource(i);
+		}
+		if (!house->isValid())
+		{
+			_streamErrors.push_back(house->getErrorLine());
+			delete house;
+			continue;
+		}
+
+		_houses[valid] = house;
+		_houseNames[valid] = house->getFilenameWithoutSuffix();
+		_streamQueue->push(valid++);
 	}
 
-	_errors.concat(_montageErrors); // insert montage errors
+	_streamedHouses = valid;
+	_streamQueue->close();
+}
 
-	if (_errors.size() > 0)
+
+// -stream: the per house results to the valid houses, their errors first like when they're all read up front
+void Simulator::finishStream()
+{
+	size_t count = _streamedHouses;
+	_houses.resize(count);
+	_houseNames.resize(count);
+	_dirtOutOfReach.resize(count);
+	_houseWallTime.resize(count);
+	_houseAlgorithmsPerf.resize(count);
+	_houseSimulatorPerf.resize(count);
+	_houseThread.resize(count);
+	for (auto it = _algoScores.begin(); it != _algoScores.end(); ++it)
 	{
-		cout << endl << "Errors:" << endl;
-		printErrors(_errors);
+		it->second->resize(count);
+	}
+	for (auto it = _houseLatency.begin(); it != _houseLatency.end(); ++it)
+	{
+		it->second.resize(count);
+	}
+	for (auto it = _allocationProfiles.begin(); it != _allocationProfiles.end(); ++it)
+	{
+		it->second.resize(count);
 	}
+
+	vector<string> errors(_errors.begin(), _errors.end());
+	_errors.clear();
+	_errors.concat(_streamErrors);
+	_errors.concat(errors);
+	_streamQueue.reset();
 }
 
 
-void Simulator::runSingleSubSimulationThread(int maxStepsAfterWinner) {
+// the run that just ended, from the latency histograms (the algorithms' steps and their time) and the wall times
+BenchmarkRun Simulator::getBenchmarkRun(uint64_t wallTime_) const
+{
+	BenchmarkRun run;
+	run.houses.resize(_houses.size());
+	run.threads.resize(_threadsCount);
+	run.constructionTime = _constructionTime;
+
+	for (auto it = _latency.cbegin(); it != _latency.cend(); ++it)
+	{
+		run.algorithms[it->first].add(it->second.count(), it->second.total());
+		run.overall.steps += it->second.count();
+	}
+	run.overall.nanoseconds = wallTime_;
+
+	for (auto it = _houseLatency.cbegin(); it != _houseLatency.cend(); ++it)
+	{
+		for (size_t i = 0; i < it->second.size(); ++i)
+		{
+			run.houses[i].steps += it->second[i].steps;
+			run.threads[_houseThread[i]].steps += it->second[i].steps;
+		}
+	}
+	for (size_t i = 0; i < _houses.size(); ++i)
+	{
+		run.houses[i].nanoseconds = _houseWallTime[i];
+	}
+	for (size_t i = 0; i < _threadsCount; ++i)
+	{
+		run.threads[i].nanoseconds = _threadWallTime[i];
+	}
+
+	return run;
+}
+
+
+void Simulator::runSingleSubSimulationThread(int maxStepsAfterWinner, size_t thread_) {
 	// ===> thread should take a new task, if available, and run it
 	// if no task is available, thread is done
 #ifdef _DEBUG_
 	sync_cout::get() << std::this_thread::get_id() << " runSingleSubSimulationThread " << endl;
 #endif
 
-	for (size_t index = _houseIndex++; index < _houses.size(); index = _houseIndex++) // fetch old value, then add. equivalent to: fetch_add(1)
+	// algorithm instances are reset and reused between the houses of this thread (if they support it)
+	AlgorithmPool pool;
+
+	unique_ptr<ParallelStepper> stepper;
+	if (_houseThreadsCount > 1)
+	{
+		stepper = make_unique<ParallelStepper>(_houseThreadsCount - 1);
+	}
+
+	uint64_t start = StepClock::isEnabled() ? StepClock::now() : 0;
+	for (size_t index = nextHouseIndex(); index < _houses.size(); index = nextHouseIndex())
+	{
+		_houseThread[index] = thread_;
+		simulateOnHouse(maxStepsAfterWinner, index, pool, stepper.get());
+	}
+
+	if (StepClock::isEnabled())
 	{
-		simulateOnHouse(maxStepsAfterWinner, index);
+		_threadWallTime[thread_] = StepClock::toNanoseconds(StepClock::now() - start);
 	}
 }
 
 
-void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index)
+void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index, AlgorithmPool& pool_, ParallelStepper* stepper_)
 {
-	House& house = *_houses.at(index);
-	vector<Simulation*> simulations;
-
 #ifdef _DEBUG_
 	sync_cout::get() << std::this_thread::get_id() << ": running on house " << index << endl << endl;
+	sync_cout::get() << *_houses.at(index) << endl;
 #endif
 
+	uint64_t start = StepClock::isEnabled() ? StepClock::now() : 0;
+	Timeline::Span span("house", index);
+
+	if (_reachableDone || _earlyAbandon)
+	{
+		_houses[index]->findDockingDistances();
+	}
+
+	map<string, AllocationProfile> setupProfiles;
+	Timeline::begin("construct / reset algorithms", index);
+	uint64_t acquireStart = StepClock::isEnabled() ? StepClock::now() : 0;
+	map<string, unique_ptr<AbstractAlgorithm>> algorithms = pool_.acquire(AllocationCounter::isProfiling() ? &setupProfiles : nullptr);
+	if (StepClock::isEnabled())
+	{
+		_constructionTime += StepClock::toNanoseconds(StepClock::now() - acquireStart);
+	}
+	Timeline::end("construct / reset algorithms");
+	for (auto it = setupProfiles.cbegin(); it != setupProfiles.cend(); ++it)
+	{
+		appendAllocationProfile(it->first, index, it->second);
+	}
+
+	// the montage needs a whole Simulation per robot
+	if (_createVideos)
+	{
+		runSimulations(maxStepsAfterWinner, index, algorithms, setupProfiles, pool_);
+	}
+	else
+	{
+		runLockstep(maxStepsAfterWinner, index, algorithms, setupProfiles, pool_, stepper_);
+	}
+
+	if (_reachableDone)
+	{
+		_dirtOutOfReach[index] = describeDirtOutOfReach(*_houses[index]);
+	}
+	if (isStreaming())
+	{
+		delete _houses[index];
+		_houses[index] = nullptr;
+	}
+
+	if (StepClock::isEnabled())
+	{
+		_houseWallTime[index] = StepClock::toNanoseconds(StepClock::now() - start); // one thread per house
+	}
+}
+
+
+void Simulator::runLockstep(int maxStepsAfterWinner, int index, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_, const map<string, AllocationProfile>& setupProfiles_, AlgorithmPool& pool_, ParallelStepper* stepper_)
+{
+	House& house = *_houses.at(index);
+
+	LockstepSimulation simulation(_config, house, algorithms_, &setupProfiles_);
+	simulation.setStepper(stepper_);
+	simulation.setDirtLeftWhenDone(getDirtLeftWhenDone(house));
+
+	int stepsCount;
+	size_t abandonedSteps;
+	vector<SimulationResult> results;
+	if (_fastForwardVerify && (_fastForwardIdleSteps > 0 || _earlyAbandon))
+	{
+		// the fast-forwarded (and early abandoning) run is only compared, the full one is reported and scored
+		map<string, unique_ptr<AbstractAlgorithm>> fastForwardAlgorithms = pool_.acquire();
+		LockstepSimulation fastForwarded(_config, house, fastForwardAlgorithms);
+		fastForwarded.setStepper(stepper_);
+		fastForwarded.setIdleWindow(_fastForwardIdleSteps);
+		fastForwarded.setDirtLeftWhenDone(getDirtLeftWhenDone(house));
+		fastForwarded.setEarlyAbandon(_earlyAbandon);
+
+		stepsCount = stepLockstep(maxStepsAfterWinner, index, simulation, true);
+		results = simulation.getResults();
+		int fastForwardStepsCount = stepLockstep(maxStepsAfterWinner, index, fastForwarded, false);
+		verifyFastForward(index, stepsCount, simulation, fastForwardStepsCount, fastForwarded);
+		abandonedSteps = fastForwarded.getAbandonedSteps();
+
+		for (size_t robot = 0; robot < fastForwarded.size(); ++robot)
+		{
+			pool_.release(fastForwarded.getAlgoName(robot), fastForwarded.releaseAlgorithm(robot));
+		}
+	}
+	else
+	{
+		simulation.setIdleWindow(_fastForwardIdleSteps);
+		simulation.setEarlyAbandon(_earlyAbandon);
+		stepsCount = stepLockstep(maxStepsAfterWinner, index, simulation, true);
+		results = simulation.getResults();
+		abandonedSteps = simulation.getAbandonedSteps();
+	}
+
+	this->score(index, stepsCount, results);
+
+	{
+		lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+		_abandonedSteps += abandonedSteps;
+		_houseSimulatorPerf[index] += simulation.getSimulatorPerf();
+	}
+
+	for (size_t robot = 0; robot < simulation.size(); ++robot)
+	{
+		if (AllocationCounter::isEnabled())
+		{
+			lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+			_allocationStats[simulation.getAlgoName(robot)].merge(simulation.getAllocationStats(robot));
+		}
+		if (StepClock::isEnabled())
+		{
+			mergeLatency(simulation.getAlgoName(robot), index, simulation.getLatency(robot));
+		}
+		mergePerf(simulation.getAlgoName(robot), index, simulation.getPerf(robot));
+		appendAllocationProfile(simulation.getAlgoName(robot), index, simulation.getAllocationProfile(robot));
+		pool_.release(simulation.getAlgoName(robot), simulation.releaseAlgorithm(robot));
+	}
+}
+
+
+// Simulate all algorithms on current house, returns the simulation steps.
+// misbehaved algorithms are reported (and get 0) only if report_
+int Simulator::stepLockstep(int maxStepsAfterWinner, int index, LockstepSimulation& simulation_, bool report_)
+{
+	House& house = *_houses.at(index);
+	int maxSteps = house.getMaxSteps();
+
+	vector<int> misbehaved;
+	bool atLeastOneDone = false, aboutToFinishCalled = false;
+	int stepsCount = 0, afterStepsCount = -1;
+	while ((simulation_.activeCount() > 0) && (stepsCount < maxSteps) && (atLeastOneDone ? (afterStepsCount < maxStepsAfterWinner) : true))
+	{
+		if (simulation_.step(misbehaved))
+		{
+			atLeastOneDone = true;
+		}
+
+		for (int robot : misbehaved)
+		{
+			if (!report_) break;
+			_errors.push_back("Algorithm " + simulation_.getAlgoName(robot) + " when running on House " + house.getFilenameWithoutSuffix() + " " + describeMisbehavior(simulation_.getMisbehavior(robot)) + " in step " + to_string(stepsCount + 1));
+			(*_algoScores[simulation_.getAlgoName(robot)])[index] = 0; // score = 0 if misbehaved
+		}
+
+		if (atLeastOneDone)
+		{
+			afterStepsCount++;
+		}
+		stepsCount++;
+
+		// Calling aboutToFinish only once per algorithm (same scenarios as in runSimulations)
+		if (!aboutToFinishCalled && (atLeastOneDone || (stepsCount == maxSteps - maxStepsAfterWinner)))
+		{
+			aboutToFinishCalled = true;
+			Timeline::Span aboutToFinish("aboutToFinish", index);
+			simulation_.aboutToFinish(min(maxSteps - stepsCount, maxStepsAfterWinner));
+		}
+
+		// only idle and abandoned robots left - nothing changes till the end (or the last abandoned one is stuck), jump there
+		if (simulation_.allParked())
+		{
+			int stepsLeft = min(maxSteps - stepsCount, simulation_.stepsToLastStop());
+			if (atLeastOneDone)
+			{
+				stepsLeft = min(stepsLeft, maxStepsAfterWinner - afterStepsCount);
+				afterStepsCount += stepsLeft;
+			}
+			simulation_.skipSteps(stepsLeft);
+			stepsCount += stepsLeft;
+		}
+	}
+
+	return stepsCount;
+}
+
+
+void Simulator::verifyFastForward(int index, int fullStepsCount_, const LockstepSimulation& full_, int stepsCount_, const LockstepSimulation& fastForwarded_)
+{
+	string house = _houses.at(index)->getFilenameWithoutSuffix();
+	string skipped = (_fastForwardIdleSteps > 0) ? "Fast forward" : "Early abandonment";
+	if (stepsCount_ != fullStepsCount_)
+	{
+		_errors.push_back(skipped + " on House " + house + " ended after " + to_string(stepsCount_) + " steps instead of " + to_string(fullStepsCount_));
+	}
+
+	// the same algorithms in the same order - robot ids match
+	vector<SimulationResult> fullResults = full_.getResults(), results = fastForwarded_.getResults();
+	for (size_t robot = 0; robot < full_.size(); ++robot)
+	{
+		string algoName = full_.getAlgoName(robot);
+		Misbehavior expectedMisbehavior = full_.getMisbehavior(robot), misbehavior = fastForwarded_.getMisbehavior(robot);
+		string change;
+		if (misbehavior != expectedMisbehavior)
+		{
+			change = "misbehavior: " + string(misbehavior == Misbehavior::None ? "none" : describeMisbehavior(misbehavior)) + " instead of " + (expectedMisbehavior == Misbehavior::None ? "none" : describeMisbehavior(expectedMisbehavior));
+		}
+		else if (misbehavior == Misbehavior::None)
+		{
+			auto byName = [&algoName](const SimulationResult& result) { return result.algoName == algoName; };
+			change = describeResultChange(*find_if(fullResults.begin(), fullResults.end(), byName), *find_if(results.begin(), results.end(), byName));
+		}
+
+		if (!change.empty())
+		{
+			_errors.push_back(skipped + " changed the result of Algorithm " + algoName + " on House " + house + " (" + change + ")");
+		}
+	}
+}
+
+
+void Simulator::runSimulations(int maxStepsAfterWinner, int index, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_, const map<string, AllocationProfile>& setupProfiles_, AlgorithmPool& pool_)
+{
+	House& house = *_houses.at(index);
+	vector<Simulation*> simulations;
+
 	// We need to set MaxSteps for each house sepreratly
 	Configuration config(_config);
 	int maxSteps = house.getMaxSteps();
 
-	map<string, unique_ptr<AbstractAlgorithm>> algorithms = AlgorithmRegistrar::getInstance().getAlgorithms();
-	for (auto a_it = algorithms.begin(); a_it != algorithms.end(); ++a_it)
+	for (auto a_it = algorithms_.begin(); a_it != algorithms_.end(); ++a_it)
 	{
-		simulations.push_back(new Simulation(config, house, a_it->second, a_it->first));
+		auto setup = setupProfiles_.find(a_it->first);
+		simulations.push_back(new Simulation(config, house, a_it->second, a_it->first, (setup != setupProfiles_.end()) ? &setup->second : nullptr));
+		simulations.back()->setDirtLeftWhenDone(getDirtLeftWhenDone(house));
 	}
 
-#ifdef _DEBUG_
-	sync_cout::get() << house << endl;
-#endif
-
 	// Simulate all algorithms on current house
 	vector<Simulation*> tempStoppedSimulatios;
 	bool atLeastOneDone = false, aboutToFinishCalled = false;
@@ -343,7 +1087,7 @@ void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index)
 				}
 				if (currentSimulation.didRobotMisbehave())
 				{
-					_errors.push_back("Algorithm " + currentSimulation.getAlgoName() + " when running on House " + house.getFilenameWithoutSuffix() + " went on a wall in step " + to_string(stepsCount + 1));
+					_errors.push_back("Algorithm " + currentSimulation.getAlgoName() + " when running on House " + house.getFilenameWithoutSuffix() + " " + describeMisbehavior(currentSimulation.getMisbehavior()) + " in step " + to_string(stepsCount + 1));
 					(*_algoScores[currentSimulation.getAlgoName()])[index] = 0; // score = 0 if misbehaved
 
 					if (_createVideos)
@@ -354,7 +1098,11 @@ void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index)
 						_montageErrors.concat(currentSimulation.getMontageErrors());
 					}
 
-					delete (*it);
+					mergeAllocationStats(currentSimulation);
+					mergeLatency(currentSimulation.getAlgoName(), index, currentSimulation.getLatency());
+					mergePerf(currentSimulation.getAlgoName(), index, currentSimulation.getPerf());
+					appendAllocationProfile(currentSimulation.getAlgoName(), index, currentSimulation.getAllocationProfile());
+					releaseSimulation(*it, pool_);
 					it = simulations.erase(it);
 				}
 				else
@@ -391,6 +1139,7 @@ void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index)
 			aboutToFinishCalled = true;
 
 			// Iterating on all active simulations and calling aboutToFinish()
+			Timeline::Span aboutToFinish("aboutToFinish", index);
 			for (vector<Simulation*>::iterator itt = simulations.begin(); itt != simulations.end(); ++itt)
 			{
 				(*itt)->CallAboutToFinish(min(maxSteps - stepsCount, maxStepsAfterWinner));
@@ -415,58 +1164,79 @@ void Simulator::simulateOnHouse(int maxStepsAfterWinner, int index)
 		}
 	}
 
-	this->score(index, stepsCount, simulations);
+	vector<SimulationResult> results;
+	for (Simulation* simulation : simulations)
+	{
+		results.push_back(simulation->getResult());
+	}
+	this->score(index, stepsCount, results);
+
+	for (Simulation* simulation : simulations)
+	{
+		mergeAllocationStats(*simulation);
+		mergeLatency(simulation->getAlgoName(), index, simulation->getLatency());
+		mergePerf(simulation->getAlgoName(), index, simulation->getPerf());
+		appendAllocationProfile(simulation->getAlgoName(), index, simulation->getAllocationProfile());
+		releaseSimulation(simulation, pool_);
+	}
+	simulations.clear();
+}
+
 
-	Simulator::clearPointersVector(simulations);
+void Simulator::releaseSimulation(Simulation* simulation_, AlgorithmPool& pool_)
+{
+	pool_.release(simulation_->getAlgoName(), simulation_->releaseAlgorithm());
+	delete simulation_;
 }
 
 
-void Simulator::score(int houseIndex_, int simulationSteps_, vector<Simulation*>& simulations_)
+void Simulator::score(int houseIndex_, int simulationSteps_, vector<SimulationResult>& results_)
 {
-	if (simulations_.size() == 0) return;
-	std::sort(simulations_.begin(), simulations_.end(), Simulation::Compare); // sort by winner score (done && less steps are first)
+	if (results_.size() == 0) return;
+	Timeline::Span span("score", houseIndex_);
+	std::sort(results_.begin(), results_.end(), SimulationResult::Compare); // sort by winner score (done && less steps are first)
 	
-	Simulation& firstSim = *simulations_.at(0);
-	int winner_num_steps = firstSim.isDone() ? firstSim.getStepsCount() : simulationSteps_;
+	SimulationResult& firstSim = results_.at(0);
+	int winner_num_steps = firstSim.done ? firstSim.steps : simulationSteps_;
 
-	for (vector<Simulation*>::iterator it = simulations_.begin(); it != simulations_.end(); ++it)
+	for (size_t i = 0; i < results_.size(); ++i)
 	{
-		Simulation& currentSim = **it;
+		SimulationResult& currentSim = results_[i];
 		
 		map<string, int> scoreParams;
-		scoreParams["actual_position_in_competition"] = this->getActualPosition(simulations_, currentSim);
+		scoreParams["actual_position_in_competition"] = this->getActualPosition(results_, i);
 		scoreParams["simulation_steps"] = simulationSteps_;
 		scoreParams["winner_num_steps"] = winner_num_steps;
-		scoreParams["this_num_steps"] = currentSim.isRobotOutOfBattery() ? simulationSteps_ : currentSim.getStepsCount();
-		scoreParams["sum_dirt_in_house"] = currentSim.getTotalDirtCount();
-		scoreParams["dirt_collected"] = currentSim.getCleanedDirtCount();
-		scoreParams["is_back_in_docking"] = currentSim.isRobotDocked() ? 1 : 0;
+		scoreParams["this_num_steps"] = currentSim.outOfBattery ? simulationSteps_ : currentSim.steps;
+		scoreParams["sum_dirt_in_house"] = currentSim.totalDirt;
+		scoreParams["dirt_collected"] = currentSim.cleanedDirt;
+		scoreParams["is_back_in_docking"] = currentSim.docked ? 1 : 0;
 
-		lock_guard<mutex> lock(_algoScoresMutex); // this lock will prevent parallel writes to _algoScores (freed when out of scope)
+		lock_guard<ProfiledMutex> lock(_algoScoresMutex); // this lock will prevent parallel writes to _algoScores (freed when out of scope)
 		int currScore = _scoreFunc(scoreParams);
 		if (currScore == -1)
 		{
 			_printScoreError = true;
 		}
-		(*_algoScores[currentSim.getAlgoName()])[houseIndex_] = currScore;
+		(*_algoScores[currentSim.algoName])[houseIndex_] = currScore;
 		
 	}
 }
 
 
-// Assumes: allSimulations_ is sorted
-int Simulator::getActualPosition(vector<Simulation*>& allSimulations_, Simulation& simulationToScore_) const
+// Assumes: allResults_ is sorted
+int Simulator::getActualPosition(const vector<SimulationResult>& allResults_, size_t resultToScore_) const
 {
 	// find actual position
 	int actual_position_in_competition = 1, sameCount = 1;
-	for (vector<Simulation*>::iterator p_it = allSimulations_.begin(); p_it != allSimulations_.end(); ++p_it)
+	for (size_t i = 0; i < allResults_.size(); ++i)
 	{
-		Simulation& currSim = **p_it;
+		const SimulationResult& currSim = allResults_[i];
 		
-		if (p_it != allSimulations_.begin())
+		if (i != 0)
 		{
-			Simulation& prevSim = **(p_it - 1);
-			if (currSim.getStepsCount() != prevSim.getStepsCount())
+			const SimulationResult& prevSim = allResults_[i - 1];
+			if (currSim.steps != prevSim.steps)
 			{
 				actual_position_in_competition += sameCount;
 				sameCount = 1;
@@ -477,7 +1247,7 @@ int Simulator::getActualPosition(vector<Simulation*>& allSimulations_, Simulatio
 			}
 		}
 
-		if (&currSim == &simulationToScore_ || !currSim.isDone()) break;
+		if (i == resultToScore_ || !currSim.done) break;
 	}
 
 	return actual_position_in_competition;
@@ -497,20 +1267,44 @@ int Simulator::CountSpaces(double avg)
 }
 
 
-vector<House*> Simulator::loadAllHouses(const char* house_path)
+// in the order of the files, whatever thread read each
+vector<House*> Simulator::loadAllHouses(const char* house_path, size_t threadsCount_)
 {
-	vector<House*> result;
 	vector<string> files = loadFilesWithSuffix(house_path, ".house");
+	vector<House*> result(files.size(), nullptr);
 
-	for (vector<string>::iterator it = files.begin(); it != files.end(); ++it)
-	{
-		result.push_back(new House((*it).c_str()));
-	}
+	parallelFor(files.size(), threadsCount_, [&files, &result](size_t index) {
+		Timeline::Span span("load house", (int)index);
+		result[index] = new House(files[index].c_str());
+	});
 
 	return result;
 }
 
 
+void Simulator::parallelFor(size_t count_, size_t threadsCount_, const function<void(size_t)>& work_)
+{
+	atomic_size_t next{0};
+	auto worker = [count_, &work_, &next]() {
+		for (size_t index = next++; index < count_; index = next++)
+		{
+			work_(index);
+		}
+	};
+
+	vector<thread> threads;
+	for (size_t i = 1; i < min(threadsCount_, count_); ++i)
+	{
+		threads.push_back(thread(worker));
+	}
+	worker();
+	for (thread& helper : threads)
+	{
+		helper.join();
+	}
+}
+
+
 
 vector<string> Simulator::loadFilesWithSuffix(const char* path_, const char* suffix_)
 {
@@ -554,15 +1348,14 @@ void Simulator::printScores() const
 	std::sort(avgScores.begin(), avgScores.end(), Simulator::avgPairCompare);
 	
 	
-	int rowLength = 2 + ALGO_NAME_CELL_SIZE + (1 + _houses.size()) * (CELL_SIZE + 1);
+	int rowLength = 2 + ALGO_NAME_CELL_SIZE + (1 + _houseNames.size()) * (CELL_SIZE + 1);
 
 	
 	// Print first row of table
 	cout << string(rowLength, '-') << endl;
 	cout << '|' << string(ALGO_NAME_CELL_SIZE, ' ') << '|';
-	for (vector<House*>::const_iterator it = _houses.begin(); it != _houses.end(); ++it)
+	for (const string& filename : _houseNames)
 	{
-		string filename = (*it)->getFilenameWithoutSuffix();
 		cout << filename.substr(0,9) << string(CELL_SIZE - min((int)filename.size(), 9), ' ') << '|';
 	}
 	cout << "AVG" << string(CELL_SIZE - 3, ' ') << '|' << endl;
@@ -594,6 +1387,215 @@ void Simulator::printScores() const
 	}
 }
 
+void Simulator::mergeAllocationStats(const Simulation& simulation_)
+{
+	if (!AllocationCounter::isEnabled()) return;
+
+	lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+	_allocationStats[simulation_.getAlgoName()].merge(simulation_.getAllocationStats());
+}
+
+
+void Simulator::printAllocationStats() const
+{
+	cout << endl << "Allocations per step:" << endl;
+	for (auto it = _allocationStats.cbegin(); it != _allocationStats.cend(); ++it)
+	{
+		const AllocationStats& stats = it->second;
+		printf("%-*s avg %.2f, ", ALGO_NAME_CELL_SIZE, it->first.c_str(), stats.average());
+		cout << "max " << stats.max << ", total " << stats.total << " (" << stats.steps << " steps)" << endl;
+	}
+}
+
+
+// houses with dirt no robot can clean - sealed off from the docking station, or too far for a full battery
+void Simulator::printDirtOutOfReach() const
+{
+	bool printedTitle = false;
+	for (const string& line : _dirtOutOfReach)
+	{
+		if (line.empty()) continue;
+
+		if (!printedTitle)
+		{
+			cout << endl << "Dirt out of reach:" << endl;
+			printedTitle = true;
+		}
+		cout << line << endl;
+	}
+}
+
+
+// empty if a robot can get to all the dirt
+string Simulator::describeDirtOutOfReach(const House& house_) const
+{
+	int sealedOff = house_.getDirtOutOfReach();
+	int tooFar = house_.getDirtOutOfReach(getBatteryReach()) - sealedOff;
+	if (sealedOff == 0 && tooFar == 0) return string();
+
+	return house_.getFilenameWithoutSuffix() + ": " + to_string(sealedOff) + " sealed off from the docking station, " + to_string(tooFar) + " out of battery range (of " + to_string(house_.getTotalDirtAmount()) + ")";
+}
+
+
+// the farthest a robot can get from the docking station - the first step from docking is charged instead of paid for,
+// each of the next ones needs some battery left before it
+int Simulator::getBatteryReach() const
+{
+	int capacity = _config["BatteryCapacity"], consumption = _config["BatteryConsumptionRate"];
+	if (consumption <= 0) return INT_MAX;
+	if (capacity <= 0) return 1;
+	return (capacity - 1) / consumption + 2;
+}
+
+
+void Simulator::appendAllocationProfile(const string& algoName_, int houseIndex_, const AllocationProfile& profile_)
+{
+	if (!AllocationCounter::isProfiling()) return;
+
+	lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+	vector<AllocationProfile>& houses = _allocationProfiles[algoName_];
+	houses.resize(_houses.size());
+	houses[houseIndex_].append(profile_);
+}
+
+
+void Simulator::printAllocationProfiles() const
+{
+	cout << endl << "Heap use (allocations, bytes allocated, peak live bytes) - operator new only, malloc / strdup in the algorithms isn't counted:" << endl;
+	for (auto it = _allocationProfiles.cbegin(); it != _allocationProfiles.cend(); ++it)
+	{
+		AllocationProfile total;
+		for (const AllocationProfile& house : it->second)
+		{
+			total.merge(house);
+		}
+
+		printf("%-*s ", ALGO_NAME_CELL_SIZE, it->first.c_str());
+		cout << total.allocations << ", " << total.bytes << ", " << total.peak << endl;
+		for (size_t i = 0; i < it->second.size(); ++i)
+		{
+			const AllocationProfile& house = it->second[i];
+			printf("  %-*s ", ALGO_NAME_CELL_SIZE - 2, _houseNames[i].c_str());
+			cout << house.allocations << ", " << house.bytes << ", " << house.peak << endl;
+		}
+	}
+}
+
+
+void Simulator::mergeLatency(const string& algoName_, int houseIndex_, const LatencyHistogram& latency_)
+{
+	if (!StepClock::isEnabled()) return;
+
+	lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+	_latency[algoName_].merge(latency_);
+
+	vector<LatencySummary>& houses = _houseLatency[algoName_];
+	houses.resize(_houses.size());
+	houses[houseIndex_] = LatencySummary(latency_);
+}
+
+
+// time spent in the algorithms' steps on a house (all algorithms)
+uint64_t Simulator::getHouseAlgorithmsTime(size_t houseIndex_) const
+{
+	uint64_t total = 0;
+	for (auto it = _houseLatency.cbegin(); it != _houseLatency.cend(); ++it)
+	{
+		total += it->second[houseIndex_].total;
+	}
+	return total;
+}
+
+
+void Simulator::printLatency() const
+{
+	cout << endl << "Step latency (ns):" << endl;
+	for (auto it = _latency.cbegin(); it != _latency.cend(); ++it)
+	{
+		const LatencyHistogram& latency = it->second;
+		printf("%-*s p50 %llu, p99 %llu, max %llu, ", ALGO_NAME_CELL_SIZE, it->first.c_str(), (unsigned long long)latency.percentile(0.5), (unsigned long long)latency.percentile(0.99), (unsigned long long)latency.max());
+		printf("total %.2fms (%llu steps)\n", latency.total() / 1e6, (unsigned long long)latency.count());
+	}
+
+	cout << endl << "House times (ms):" << endl;
+	for (size_t i = 0; i < _houses.size(); ++i)
+	{
+		printf("%-*s wall %.2f, algorithms %.2f\n", ALGO_NAME_CELL_SIZE, _houseNames[i].c_str(), _houseWallTime[i] / 1e6, getHouseAlgorithmsTime(i) / 1e6);
+	}
+}
+
+
+bool Simulator::writeLatencyJson(const string& path_) const
+{
+	ofstream out(path_);
+	if (!out.is_open()) return false;
+
+	auto summary = [&out](const LatencySummary& s) {
+		out << "\"steps\": " << s.steps << ", \"total_ns\": " << s.total << ", \"p50_ns\": " << s.p50 << ", \"p99_ns\": " << s.p99 << ", \"max_ns\": " << s.max;
+	};
+
+	out << "{" << endl << "  \"algorithms\": [";
+	for (auto it = _latency.cbegin(); it != _latency.cend(); ++it)
+	{
+		out << (it == _latency.cbegin() ? "" : ",") << endl << "    { \"name\": \"" << StringUtils::jsonEscape(it->first) << "\", ";
+		summary(LatencySummary(it->second));
+		out << "," << endl << "      \"houses\": [";
+
+		const vector<LatencySummary>& houses = _houseLatency.at(it->first);
+		for (size_t i = 0; i < houses.size(); ++i)
+		{
+			out << (i == 0 ? "" : ",") << endl << "        { \"house\": \"" << StringUtils::jsonEscape(_houseNames[i]) << "\", ";
+			summary(houses[i]);
+			out << " }";
+		}
+		out << " ] }";
+	}
+
+	out << " ]," << endl << "  \"houses\": [";
+	for (size_t i = 0; i < _houses.size(); ++i)
+	{
+		out << (i == 0 ? "" : ",") << endl << "    { \"name\": \"" << StringUtils::jsonEscape(_houseNames[i]) << "\", \"wall_ns\": " << _houseWallTime[i] << ", \"algorithms_ns\": " << getHouseAlgorithmsTime(i) << " }";
+	}
+	out << " ]" << endl << "}" << endl;
+
+	return out.good();
+}
+
+
+void Simulator::mergePerf(const string& algoName_, int houseIndex_, const PerfSample& perf_)
+{
+	if (!PerfCounters::isEnabled()) return;
+
+	lock_guard<ProfiledMutex> lock(_algoScoresMutex);
+	_perf[algoName_] += perf_;
+	_houseAlgorithmsPerf[houseIndex_] += perf_;
+}
+
+
+void Simulator::printPerfLine(const string& name_, const PerfSample& perf_)
+{
+	printf("%-*s IPC %.2f, cache misses %.2f, branch misses %.2f per 1k instructions", ALGO_NAME_CELL_SIZE, name_.c_str(), perf_.ipc(), perf_.perKiloInstructions(perf_.cacheMisses), perf_.perKiloInstructions(perf_.branchMisses));
+	printf(" (%llu cycles, %llu instructions)\n", (unsigned long long)perf_.cycles, (unsigned long long)perf_.instructions);
+}
+
+
+void Simulator::printPerf() const
+{
+	cout << endl << "Hardware counters in the algorithms' steps:" << endl;
+	for (auto it = _perf.cbegin(); it != _perf.cend(); ++it)
+	{
+		printPerfLine(it->first, it->second);
+	}
+
+	cout << endl << "Hardware counters per house (algorithms, then the simulator):" << endl;
+	for (size_t i = 0; i < _houses.size(); ++i)
+	{
+		printPerfLine(_houseNames[i], _houseAlgorithmsPerf[i]);
+		printPerfLine("  simulator", _houseSimulatorPerf[i]); // lockstep runs only
+	}
+}
+
+
 template <class T>
 void Simulator::printErrors(const T& errors_) const
 {
@@ -12,6 +12,13 @@ using namespace std;
 
 #include "Simulation.h"
 #include "AlgorithmRegistrar.h"
+#include "AlgorithmPool.h"
+#include "LockstepSimulation.h"
+#include "Timeline.h"
+#include "ProfiledMutex.h"
+#include "Benchmark.h"
+#include "HousePack.h"
+#include "BoundedQueue.h"
 
 #define ALGO_NAME_CELL_SIZE 13
 #define CELL_SIZE 10
@@ -21,15 +28,15 @@ template <class T>
 class syncVector
 {
 	std::vector<T> _vector;
-	mutex _mutex;
+	ProfiledMutex _mutex;
 public:
-	syncVector() {}
-	syncVector(size_t n) : _vector(n) {}
+	explicit syncVector(const string& name_ = "syncVector") : _mutex(name_ + "::_mutex", "wait: syncVector mutex") {}
+	syncVector(size_t n) : _vector(n), _mutex("syncVector::_mutex", "wait: syncVector mutex") {}
 
-	void push_back(const T& val) { lock_guard<mutex> lock(_mutex); _vector.push_back(val); }
-	void push_back(T&& val) { lock_guard<mutex> lock(_mutex); _vector.push_back(val); }
-	void clear() { lock_guard<mutex> lock(_mutex); _vector.clear(); }
-	size_t size() { lock_guard<mutex> lock(_mutex); return _vector.size(); }
+	void push_back(const T& val) { lock_guard<ProfiledMutex> lock(_mutex); _vector.push_back(val); }
+	void push_back(T&& val) { lock_guard<ProfiledMutex> lock(_mutex); _vector.push_back(val); }
+	void clear() { lock_guard<ProfiledMutex> lock(_mutex); _vector.clear(); }
+	size_t size() { lock_guard<ProfiledMutex> lock(_mutex); return _vector.size(); }
 	
 	typename std::vector<T>::const_iterator begin() const { return _vector.cbegin(); }
 	typename std::vector<T>::const_iterator end() const { return _vector.cend(); }
@@ -37,7 +44,7 @@ public:
 	template <class OtherContainer>
 	void concat(const OtherContainer& other)
 	{
-		lock_guard<mutex> lock(_mutex);
+		lock_guard<ProfiledMutex> lock(_mutex);
 		for (auto e : other)
 		{
 			_vector.push_back(e);
@@ -52,6 +59,18 @@ class Simulator
 
 	Configuration	_config;
 	vector<House*>	_houses;
+	unique_ptr<HousePack>	_housePack;	// the houses are in it, with -house_path <.hpack file>
+	vector<string>	_houseNames;		// per house, for the reports - with -stream the houses are gone by then
+	vector<string>	_dirtOutOfReach;	// per house, only filled with -reachable_done
+
+	// -stream: houses are made one by one (in order) by a producer thread while the others simulate, each is freed once
+	// it's scored. _houses has a slot per source item till the run ends, then the valid ones
+	function<House*(size_t)>				_streamSource;	// item i of the source
+	size_t									_streamCount = 0;
+	unique_ptr<BoundedQueue<size_t>>		_streamQueue;	// indices of the houses ready to simulate
+	size_t									_streamedHouses = 0;
+	vector<string>							_streamErrors;	// of the invalid houses, in order
+	string									_streamAllInvalid;	// the message if no house is valid
 
 	SharedObjectLoader*	_scoreSO = nullptr;
 	typedef int(*score_func)(const map<string, int>&);
@@ -60,43 +79,136 @@ class Simulator
 	
 	bool	_createVideos;
 	size_t	_threadsCount;
+	size_t	_houseThreadsCount = 1;	// threads stepping the algorithms of one house together (per house thread)
+	int		_fastForwardIdleSteps = 0;	// 0 = idle robots are stepped till the end
+	bool	_fastForwardVerify = false;
+	bool	_reachableDone = false;		// the dirt no robot can get to doesn't count
+	bool	_earlyAbandon = false;
+	size_t	_abandonedSteps = 0;		// steps of lost robots that were counted without their algorithms
 
 	bool _successful = false;
-	syncVector<string>	_errors;
-	syncVector<string>	_montageErrors;
+	syncVector<string>	_errors{"Simulator::_errors"};
+	syncVector<string>	_montageErrors{"Simulator::_montageErrors"};
 
 	map<string, unique_ptr<vector<int>>>	_algoScores;
+	map<string, AllocationStats>			_allocationStats;	// only filled with -alloc_count
+	map<string, vector<AllocationProfile>>	_allocationProfiles;	// per algorithm, per house - only filled with -alloc_profile
+
+	// only filled with -latency / -latency_json
+	map<string, LatencyHistogram>			_latency;			// per algorithm, all houses
+	map<string, vector<LatencySummary>>		_houseLatency;		// per algorithm, per house
+	vector<uint64_t>						_houseWallTime;		// ns, per house
+	bool									_printLatency = false;
+	string									_latencyJsonPath;
+
+	// only filled with -perf
+	map<string, PerfSample>					_perf;					// per algorithm, all houses
+	vector<PerfSample>						_houseAlgorithmsPerf;	// per house, all algorithms
+	vector<PerfSample>						_houseSimulatorPerf;	// per house, the simulator's phases of the steps
+
+	// setup times (ns), the rest is only filled with StepClock on (-benchmark)
+	uint64_t								_housesLoadTime = 0;
+	uint64_t								_algorithmsLoadTime = 0;
+	atomic<uint64_t>						_constructionTime{0};	// all threads, acquiring the algorithms from their pools
+	vector<size_t>							_houseThread;			// per house, the thread that ran it
+	vector<uint64_t>						_threadWallTime;		// ns, per thread
 
 	atomic_size_t	_houseIndex{0};
-	mutex			_algoScoresMutex;
+	atomic_size_t	_houseIndexFetches{0};	// with the lock statistics on (-thread_sweep)
+	atomic_size_t	_houseIndexRetries{0};	// compare-and-swap retries - threads taking a house at the same time
+	ProfiledMutex	_algoScoresMutex{"Simulator::_algoScoresMutex", "wait: scores mutex"};
 	
 public:
-	Simulator(const Configuration& conf_, const char* housePath_ = NULL, const char* algorithmPath_ = NULL, const char* scorePath_ = NULL, const char* threadsCount_ = NULL, bool createVideos_ = false);
+	// houseGen_ (-house_gen, see HouseGenerator::Spec) generates the houses in memory instead of reading housePath_.
+	// with streamHouses_ (-stream) the houses of a directory or a generator are made while the tournament runs (simulate only)
+	Simulator(const Configuration& conf_, const char* housePath_ = NULL, const char* algorithmPath_ = NULL, const char* scorePath_ = NULL, const char* threadsCount_ = NULL, bool createVideos_ = false,
+		const char* houseGen_ = NULL, bool streamHouses_ = false);
 	~Simulator();
 
+	// the valid houses of housePath_ to a house pack at packPath_ (reading them on threadsCount_ threads), instead of simulating
+	static bool writeHousePack(const char* housePath_, size_t threadsCount_, const char* packPath_);
+
 	bool isReady() { return _successful; }
 	void simulate();
 
+	// runs_ runs of the tournament without printing the results, then the throughput / setup report (needs StepClock::enable()),
+	// also written as JSON to jsonPath_ if not empty
+	void benchmark(int runs_, const string& jsonPath_);
+
+	// the tournament at 1, 2, 4 ... maxThreads_ threads without printing the results - wall times, speedup and
+	// parallel efficiency, and the lock statistics of every ProfiledMutex (and the house index) at each thread count
+	void threadSweep(size_t maxThreads_);
+
+	// every algorithm on generated houses of doubling area up to maxCells_, instead of the tournament - the growth of
+	// the per-step time and allocations (needs StepClock::enable() and AllocationCounter::enable())
+	void scaling(size_t maxCells_);
+
+	// idle robots are fast-forwarded to the end after idleSteps_ steps in the same 1 or 2 step loop.
+	// with verify_ every house is also run in full - the full run is scored, differences are reported as errors
+	void setFastForward(int idleSteps_, bool verify_) { _fastForwardIdleSteps = idleSteps_; _fastForwardVerify = verify_; }
+
+	// a robot is done once it cleaned all the dirt it can get to (from the docking station, with a full battery) and is back in docking
+	void setReachableDone(bool reachableDone_) { _reachableDone = reachableDone_; }
+
+	// robots that can't get back to docking or to any more dirt aren't stepped any more, only their steps till the battery runs out are counted
+	void setEarlyAbandon(bool earlyAbandon_) { _earlyAbandon = earlyAbandon_; }
+
+	// step latency report (needs StepClock::enable()) - printed after the scores if print_, written as JSON to jsonPath_ if not empty
+	void setLatencyReport(bool print_, const string& jsonPath_) { _printLatency = print_; _latencyJsonPath = jsonPath_; }
+
 private:
-	void score(int houseIndex_, int simulationSteps_, vector<Simulation*>& simulatios_);
-	int getActualPosition(vector<Simulation*>& allSimulatios_, Simulation& simulationToScore_) const;
+	void setThreads(size_t requestedThreadsCount_);
+	size_t nextHouseIndex();
+	void runTournament();
+	BenchmarkRun getBenchmarkRun(uint64_t wallTime_) const;
+	void score(int houseIndex_, int simulationSteps_, vector<SimulationResult>& results_);
+	int getActualPosition(const vector<SimulationResult>& allResults_, size_t resultToScore_) const;
 	void printScores() const;
+	void mergeAllocationStats(const Simulation& simulation_);
+	void printAllocationStats() const;
+	void appendAllocationProfile(const string& algoName_, int houseIndex_, const AllocationProfile& profile_);
+	void printAllocationProfiles() const;
+	void mergeLatency(const string& algoName_, int houseIndex_, const LatencyHistogram& latency_);
+	uint64_t getHouseAlgorithmsTime(size_t houseIndex_) const;
+	void printLatency() const;
+	bool writeLatencyJson(const string& path_) const;
+	void mergePerf(const string& algoName_, int houseIndex_, const PerfSample& perf_);
+	void printPerf() const;
+	static void printPerfLine(const string& name_, const PerfSample& perf_);
+	void printDirtOutOfReach() const;
+	int getBatteryReach() const;
+	int getDirtLeftWhenDone(const House& house_) const { return _reachableDone ? house_.getDirtOutOfReach(getBatteryReach()) : 0; }
 	
 	template <class T>
 	void printErrors(const T& errors_) const;
 
 	static int CountSpaces(double avg);
 
-	vector<House*> loadAllHouses(const char* house_path);
-	vector<string> loadFilesWithSuffix(const char* path, const char* suffix);
+	// work_(0) ... work_(count_ - 1) on up to threadsCount_ threads (the calling thread is one of them)
+	static void parallelFor(size_t count_, size_t threadsCount_, const function<void(size_t)>& work_);
+
+	static vector<House*> loadAllHouses(const char* house_path, size_t threadsCount_);
+	static vector<string> loadFilesWithSuffix(const char* path, const char* suffix);
 
 	bool getAlgos(const char* algorithmPath_, vector<string>& errors_);
-	bool getHouses(const char* housePath_);
+	bool getHouses(const char* housePath_, size_t threadsCount_, bool stream_);
+	bool getGeneratedHouses(const char* spec_, size_t threadsCount_, bool stream_);
+	void setStream(size_t count_, const function<House*(size_t)>& source_, const string& allInvalid_);
+	bool isStreaming() const { return (bool)_streamSource; }
+	void produceHouses();
+	void finishStream();
+	string describeDirtOutOfReach(const House& house_) const;
+	bool getPackedHouses(const string& packPath_);
 	bool getScoreFunc(const char* scorePath_);
 	size_t getThreadsFromString(const char* threads_count) const;
 
-	void runSingleSubSimulationThread(int maxStepsAfterWinner);
-	void simulateOnHouse(int maxStepsAfterWinner, int index);
+	void runSingleSubSimulationThread(int maxStepsAfterWinner, size_t thread_);
+	void simulateOnHouse(int maxStepsAfterWinner, int index, AlgorithmPool& pool_, ParallelStepper* stepper_);
+	void runSimulations(int maxStepsAfterWinner, int index, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_, const map<string, AllocationProfile>& setupProfiles_, AlgorithmPool& pool_);
+	void runLockstep(int maxStepsAfterWinner, int index, map<string, unique_ptr<AbstractAlgorithm>>& algorithms_, const map<string, AllocationProfile>& setupProfiles_, AlgorithmPool& pool_, ParallelStepper* stepper_);
+	int stepLockstep(int maxStepsAfterWinner, int index, LockstepSimulation& simulation_, bool report_);
+	void verifyFastForward(int index, int fullStepsCount_, const LockstepSimulation& full_, int stepsCount_, const LockstepSimulation& fastForwarded_);
+	void releaseSimulation(Simulation* simulation_, AlgorithmPool& pool_);
 	template <class T>
 	
 	static void clearPointersVector(vector<T*>& vec);
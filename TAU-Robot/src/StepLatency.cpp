@@ -0,0 +1,151 @@
+#include "StepLatency.h"
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <ctime>
+
+#if !defined(_WINDOWS_) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STEP_CLOCK_TSC
+#include <x86intrin.h>
+#endif
+
+
+atomic_bool StepClock::_enabled(false);
+double StepClock::_nanosecondsPerTick = 1.0;
+
+
+void StepClock::enable()
+{
+#ifdef STEP_CLOCK_TSC
+	// ticks per ns over a short sleep (the TSC of current CPUs runs at a constant rate)
+	auto start = chrono::steady_clock::now();
+	uint64_t startTicks = now();
+	this_thread::sleep_for(chrono::milliseconds(20));
+	uint64_t ticks = now() - startTicks;
+	auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+
+	if (ticks > 0)
+	{
+		_nanosecondsPerTick = (double)elapsed / ticks;
+	}
+#endif
+	_enabled = true;
+}
+
+
+uint64_t StepClock::now()
+{
+#ifdef STEP_CLOCK_TSC
+	return __rdtsc();
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+uint64_t StepClock::threadCpuTime()
+{
+#if !defined(_WINDOWS_) && defined(CLOCK_THREAD_CPUTIME_ID)
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+int LatencyHistogram::bucketOf(uint64_t value)
+{
+	if (value < SUB_BUCKETS)
+	{
+		return (int)value;
+	}
+
+	int exponent = 0;
+	for (uint64_t v = value; v > 1; v >>= 1) ++exponent;
+
+	return (exponent - 2) * SUB_BUCKETS + (int)((value >> (exponent - 3)) & (SUB_BUCKETS - 1));
+}
+
+
+uint64_t LatencyHistogram::bucketStart(int bucket)
+{
+	if (bucket < SUB_BUCKETS)
+	{
+		return bucket;
+	}
+
+	int exponent = bucket / SUB_BUCKETS + 2;
+	return (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3);
+}
+
+
+uint64_t LatencyHistogram::bucketEnd(int bucket)
+{
+	if (bucket < SUB_BUCKETS)
+	{
+		return bucket;
+	}
+
+	int exponent = bucket / SUB_BUCKETS + 2;
+	return bucketStart(bucket) + ((uint64_t)1 << (exponent - 3)) - 1;
+}
+
+
+void LatencyHistogram::add(uint64_t nanoseconds_)
+{
+	_buckets[bucketOf(nanoseconds_)]++;
+	_count++;
+	_total += nanoseconds_;
+	if (nanoseconds_ > _max) _max = nanoseconds_;
+}
+
+
+void LatencyHistogram::merge(const LatencyHistogram& other_)
+{
+	for (int i = 0; i < BUCKETS; ++i)
+	{
+		_buckets[i] += other_._buckets[i];
+	}
+	_count += other_._count;
+	_total += other_._total;
+	if (other_._max > _max) _max = other_._max;
+}
+
+
+uint64_t LatencyHistogram::percentile(double p_) const
+{
+	if (_count == 0) return 0;
+
+	size_t rank = (size_t)std::ceil(p_ * _count);
+	if (rank == 0) rank = 1;
+	if (rank >= _count) return _max;
+
+	size_t seen = 0;
+	for (int i = 0; i < BUCKETS; ++i)
+	{
+		if (seen + _buckets[i] >= rank)
+		{
+			// the latencies of a bucket are taken as spread evenly over it - the rank-th one is in the middle of its share
+			uint64_t start = bucketStart(i);
+			double width = (double)(std::min(bucketEnd(i), _max) - start + 1);
+			uint64_t value = start + (uint64_t)(width * (rank - seen - 0.5) / _buckets[i]);
+			return std::min(value, _max);
+		}
+		seen += _buckets[i];
+	}
+	return _max;
+}
+
+
+LatencySummary::LatencySummary(const LatencyHistogram& histogram_)
+{
+	steps = histogram_.count();
+	total = histogram_.total();
+	p50 = histogram_.percentile(0.5);
+	p99 = histogram_.percentile(0.99);
+	max = histogram_.max();
+}
@@ -0,0 +1,76 @@
+#ifndef __STEP_LATENCY__H_
+#define __STEP_LATENCY__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+
+// Cheap timestamps for timing the algorithms' steps - the TSC where the compiler / CPU have it (calibrated against
+// steady_clock once, in enable()), steady_clock otherwise.
+// Off unless enable() was called (-latency / -latency_json).
+class StepClock
+{
+	static atomic_bool	_enabled;
+	static double		_nanosecondsPerTick;
+
+public:
+	static void enable();
+	static bool isEnabled() { return _enabled; }
+
+	static uint64_t now();
+	static uint64_t toNanoseconds(uint64_t ticks_) { return (uint64_t)(ticks_ * _nanosecondsPerTick); }
+
+	// CPU time of the calling thread (ns) - a system call, only for the CPU budgets. Wall time where there's no thread clock.
+	static uint64_t threadCpuTime();
+};
+
+
+// Log-linear histogram of step latencies (ns) - exact below 8ns, then 8 buckets per power of 2 (up to 12.5% error).
+// Fixed size, adding a latency doesn't allocate.
+class LatencyHistogram
+{
+public:
+	enum { SUB_BUCKETS = 8, BUCKETS = 62 * SUB_BUCKETS };
+
+private:
+	uint32_t	_buckets[BUCKETS] = {};
+	size_t		_count = 0;
+	uint64_t	_total = 0;
+	uint64_t	_max = 0;
+
+public:
+	void add(uint64_t nanoseconds_);
+	void merge(const LatencyHistogram& other_);
+
+	size_t count() const { return _count; }
+	uint64_t total() const { return _total; }
+	uint64_t max() const { return _max; }
+
+	// the p_ (0..1) quantile, interpolated within its bucket (exact below 8ns)
+	uint64_t percentile(double p_) const;
+
+private:
+	static int bucketOf(uint64_t value);
+	static uint64_t bucketStart(int bucket);
+	static uint64_t bucketEnd(int bucket);
+};
+
+
+// what is kept of a histogram per algorithm per house
+struct LatencySummary
+{
+	size_t		steps = 0;
+	uint64_t	total = 0;
+	uint64_t	p50 = 0;
+	uint64_t	p99 = 0;
+	uint64_t	max = 0;
+
+	LatencySummary() = default;
+	explicit LatencySummary(const LatencyHistogram& histogram_);
+};
+
+
+#endif //__STEP_LATENCY__H_
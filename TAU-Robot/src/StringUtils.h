@@ -33,6 +33,18 @@ public:
 		}
 		return path;
 	}
+
+	// value as the contents of a JSON string
+	static std::string jsonEscape(const std::string& value)
+	{
+		std::string escaped;
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
 };
 
 
@@ -0,0 +1,111 @@
+#include "Timeline.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+atomic_bool Timeline::_enabled(false);
+
+
+namespace
+{
+	struct Event
+	{
+		const char*	name;
+		uint64_t	time;	// ns
+		int			arg;
+		char		phase;	// 'B' / 'E'
+	};
+
+	// written by its thread only, read by write() after the threads are done
+	struct ThreadEvents
+	{
+		enum { CAPACITY = 1 << 16 };
+
+		vector<Event>		events;
+		atomic<size_t>		recorded{0};	// events[recorded % CAPACITY] is the next one
+		int					tid;
+
+		explicit ThreadEvents(int tid_) : events(CAPACITY), tid(tid_) {}
+	};
+
+	uint64_t now()
+	{
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	const uint64_t origin = now();
+
+	mutex threadsMutex;	// only taken the first time a thread records
+	vector<unique_ptr<ThreadEvents>> threads;
+	thread_local ThreadEvents* threadEvents = nullptr;
+
+	ThreadEvents& currentThread()
+	{
+		if (threadEvents == nullptr)
+		{
+			lock_guard<mutex> lock(threadsMutex);
+			threads.push_back(unique_ptr<ThreadEvents>(new ThreadEvents((int)threads.size() + 1)));
+			threadEvents = threads.back().get();
+		}
+		return *threadEvents;
+	}
+
+	void record(const char* name, int arg, char phase)
+	{
+		ThreadEvents& thread = currentThread();
+		size_t i = thread.recorded.load(memory_order_relaxed);
+		thread.events[i % ThreadEvents::CAPACITY] = Event{ name, now() - origin, arg, phase };
+		thread.recorded.store(i + 1, memory_order_release);
+	}
+}
+
+
+void Timeline::begin(const char* name_, int arg_)
+{
+	if (!isEnabled()) return;
+	record(name_, arg_, 'B');
+}
+
+
+void Timeline::end(const char* name_)
+{
+	if (!isEnabled()) return;
+	record(name_, -1, 'E');
+}
+
+
+bool Timeline::write(const string& path_)
+{
+	ofstream out(path_);
+	if (!out.is_open()) return false;
+
+	lock_guard<mutex> lock(threadsMutex);
+	out << "{\"traceEvents\": [";
+	const char* separator = "\n";
+	for (const unique_ptr<ThreadEvents>& thread : threads)
+	{
+		out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->tid << ", \"args\": {\"name\": \"thread " << thread->tid << "\"}}";
+		separator = ",\n";
+
+		size_t recorded = thread->recorded.load(memory_order_acquire);
+		size_t first = (recorded > ThreadEvents::CAPACITY) ? recorded - ThreadEvents::CAPACITY : 0;
+		for (size_t i = first; i < recorded; ++i)
+		{
+			const Event& event = thread->events[i % ThreadEvents::CAPACITY];
+			out << separator << "{\"name\": \"" << event.name << "\", \"ph\": \"" << event.phase << "\", \"ts\": " << event.time / 1000 << "." << event.time % 1000 / 100 << event.time % 100 / 10 << event.time % 10;
+			out << ", \"pid\": 1, \"tid\": " << thread->tid;
+			if (event.arg >= 0)
+			{
+				out << ", \"args\": {\"index\": " << event.arg << "}";
+			}
+			out << "}";
+		}
+	}
+	out << "\n]}" << endl;
+
+	return out.good();
+}
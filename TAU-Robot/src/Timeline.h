@@ -0,0 +1,44 @@
+#ifndef __TIMELINE__H_
+#define __TIMELINE__H_
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+
+// Begin / end events of the simulator's work (house loading, houses, scoring, montage, lock waits - see ProfiledMutex...) for -timeline <file>.
+// Every thread records into its own ring buffer (no locks, the oldest events are overwritten when it's full),
+// write() makes a Chrome trace-event JSON of all of them (chrome://tracing, Perfetto) once the threads are done.
+// Event names are kept by pointer - string literals only.
+class Timeline
+{
+	static atomic_bool	_enabled;
+
+public:
+	static void enable() { _enabled = true; }
+	static bool isEnabled() { return _enabled; }
+
+	// no-ops unless enabled; arg_ (>= 0) is shown as the event's "index" argument (e.g. the house index)
+	static void begin(const char* name_, int arg_ = -1);
+	static void end(const char* name_);
+
+	static bool write(const string& path_);
+
+	// begin .. end of a scope
+	class Span
+	{
+		const char*	_name;
+
+	public:
+		explicit Span(const char* name_, int arg_ = -1) : _name(name_) { begin(_name, arg_); }
+		~Span() { end(_name); }
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	};
+};
+
+
+#endif //__TIMELINE__H_
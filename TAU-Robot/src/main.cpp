@@ -1,9 +1,16 @@
 #include <cstdlib>
 #include <cstdio>
 #include <ctime>
+#include <algorithm>
+#include <thread>
 
 #include "ParamsParser.h"
 #include "Simulator.h"
+#include "AllocationCounter.h"
+#include "StepLatency.h"
+#include "PerfCounters.h"
+#include "Timeline.h"
+#include "Profiler.h"
 
 
 int main(int argc, char* argv[])
@@ -18,13 +25,101 @@ int main(int argc, char* argv[])
 	threadsCount = params["-threads"];
 	bool createVideos = params["-video"] != NULL;
 
+	if (params["-alloc_count"] != NULL || params["-scaling"] != NULL)
+	{
+		AllocationCounter::enable();
+	}
+
+	if (params["-alloc_profile"] != NULL)
+	{
+		AllocationCounter::enableProfiling();
+	}
+
+	if (params["-latency"] != NULL || params["-latency_json"] != NULL || params["-benchmark"] != NULL || params["-scaling"] != NULL)
+	{
+		StepClock::enable();
+	}
+
+	if (params["-perf"] != NULL)
+	{
+		string why;
+		if (!PerfCounters::enable(why))
+		{
+			cout << "Hardware counters are not available (" << why << "), running without -perf" << endl;
+		}
+	}
+
+	if (params["-timeline"] != NULL)
+	{
+		Timeline::enable();
+	}
+
+	if (params["-write_house_pack"] != NULL)
+	{
+		// only converts the houses, no simulation
+		size_t threads = (threadsCount != NULL) ? max(atoi(threadsCount), 1) : 1;
+		return Simulator::writeHousePack(house_path, threads, params["-write_house_pack"]) ? 0 : -1;
+	}
+
 	Configuration config(conf_path);
 	if (!config.isReady()) goto error;
 
 	{
-		Simulator simulator(config, house_path, algorithm_path, score_path, threadsCount, createVideos);
+		Simulator simulator(config, house_path, algorithm_path, score_path, threadsCount, createVideos, params["-house_gen"], params["-stream"] != NULL);
 		if (!simulator.isReady()) goto error;
-		simulator.simulate();
+		// -fast_forward_verify checks -early_abandon too, with or without -fast_forward
+		simulator.setFastForward((params["-fast_forward"] != NULL) ? max(atoi(params["-fast_forward"]), 0) : 0, params["-fast_forward_verify"] != NULL);
+		simulator.setReachableDone(params["-reachable_done"] != NULL);
+		simulator.setEarlyAbandon(params["-early_abandon"] != NULL);
+		simulator.setLatencyReport(params["-latency"] != NULL, params["-latency_json"] != NULL ? params["-latency_json"] : "");
+
+		// the algorithms are loaded by now - their frames can be told apart
+		string why;
+		bool profiling = (params["-profile"] != NULL);
+		if (profiling && !Profiler::start(1000, why))
+		{
+			cout << "Cannot start the CPU profiler (" << why << "), running without -profile" << endl;
+			profiling = false;
+		}
+
+		if (params["-benchmark"] != NULL)
+		{
+			int runs = (params["-benchmark_runs"] != NULL) ? max(atoi(params["-benchmark_runs"]), 1) : 5;
+			simulator.benchmark(runs, params["-benchmark_json"] != NULL ? params["-benchmark_json"] : "");
+		}
+		else if (params["-scaling"] != NULL)
+		{
+			size_t maxCells = (params["-scaling_cells"] != NULL) ? max(atoi(params["-scaling_cells"]), 1) : 16384;
+			simulator.scaling(maxCells);
+		}
+		else if (params["-thread_sweep"] != NULL)
+		{
+			// up to -threads, or all the hardware threads
+			size_t maxThreads = (threadsCount != NULL) ? max(atoi(threadsCount), 1) : max(thread::hardware_concurrency(), 1u);
+			simulator.threadSweep(maxThreads);
+		}
+		else
+		{
+			simulator.simulate();
+		}
+
+		if (profiling)
+		{
+			Profiler::stop();
+			if (Profiler::write(params["-profile"]))
+			{
+				Profiler::printSummary();
+			}
+			else
+			{
+				cout << "Cannot write the CPU profile to " << params["-profile"] << endl;
+			}
+		}
+
+		if (params["-timeline"] != NULL && !Timeline::write(params["-timeline"]))
+		{
+			cout << "Cannot write the timeline to " << params["-timeline"] << endl;
+		}
 	}
 
 #ifdef _WINDOWS_